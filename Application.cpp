@@ -95,6 +95,9 @@ namespace ClassGame {
                         
                         // Show move count
                         ImGui::Text("Move Count: %d", chessGame->getMoveCount());
+                        if (chessGame->isThinking()) {
+                            ImGui::Text("Engine thinking...");
+                        }
                     }
                 }
                 ImGui::End();
@@ -106,11 +109,14 @@ namespace ClassGame {
                         game->updateAI();
                     }
                     
-                    // Handle automated gameplay for Chess
+                    // Handle automated gameplay for Chess: the engine searches on a worker
+                    // thread and its move is applied here on a later frame once it's done
                     if (chessGame && !gameOver) {
                         int currentPlayer = game->getCurrentPlayer()->playerNumber();
                         if ((currentPlayer == 0 && whiteAI) || (currentPlayer == 1 && blackAI)) {
-                            chessGame->makeRandomMoveForCurrentPlayer();
+                            chessGame->updateBackgroundMove();
+                        } else if (chessGame->isThinking()) {
+                            chessGame->cancelThinking();
                         }
                     }
                     
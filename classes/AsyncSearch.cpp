@@ -0,0 +1,48 @@
+#include "AsyncSearch.h"
+
+void AsyncSearch::start(const ChessPosition &position, SearchLimits limits)
+{
+    cancel();
+
+    auto token = std::make_shared<std::atomic<bool>>(false);
+    _cancel = token;
+    limits.cancel = token.get();
+    _running.store(true, std::memory_order_release);
+
+    _thread = std::thread([this, snapshot = position, limits, token] {
+        ChessMove move = _search.findBestMove(snapshot, limits);
+        {
+            std::lock_guard<std::mutex> lock(_mutex);
+            if (!token->load(std::memory_order_relaxed)) {
+                _move = move;
+                _positionKey = snapshot.key();
+                _ready = true;
+            }
+        }
+        _running.store(false, std::memory_order_release);
+    });
+}
+
+void AsyncSearch::cancel()
+{
+    if (_cancel) {
+        _cancel->store(true, std::memory_order_relaxed);
+    }
+    if (_thread.joinable()) {
+        _thread.join();
+    }
+    std::lock_guard<std::mutex> lock(_mutex);
+    _ready = false;
+}
+
+bool AsyncSearch::takeMove(ChessMove &move, uint64_t &positionKey)
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    if (!_ready) {
+        return false;
+    }
+    move = _move;
+    positionKey = _positionKey;
+    _ready = false;
+    return true;
+}
@@ -0,0 +1,46 @@
+#pragma once
+
+#include "ChessSearch.h"
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <thread>
+
+//
+// runs ChessSearch::findBestMove on a background thread so the caller (the render
+// loop) never blocks on it. The search works on a snapshot of the position; the
+// finished move is handed back through takeMove() for the caller to apply.
+//
+// Each search gets its own cancellation token. cancel() sets it, waits for the
+// thread and throws the result away, so a move computed for a position that was
+// reset or changed in the meantime is never delivered.
+//
+class AsyncSearch
+{
+public:
+    explicit AsyncSearch(ChessSearch &search) : _search(search) {}
+    ~AsyncSearch() { cancel(); }
+
+    AsyncSearch(const AsyncSearch &) = delete;
+    AsyncSearch &operator=(const AsyncSearch &) = delete;
+
+    // cancels any search in progress, then starts one on a copy of the position
+    void start(const ChessPosition &position, SearchLimits limits);
+    void cancel();
+
+    // true from start() until the search thread has finished
+    bool thinking() const { return _running.load(std::memory_order_acquire); }
+    // the finished move and the key of the position it was searched for, once per search
+    bool takeMove(ChessMove &move, uint64_t &positionKey);
+
+private:
+    ChessSearch &_search;
+    std::thread _thread;
+    std::shared_ptr<std::atomic<bool>> _cancel;
+    std::atomic<bool> _running{false};
+
+    std::mutex _mutex;      // guards the result handoff below
+    bool _ready = false;
+    ChessMove _move;
+    uint64_t _positionKey = 0;
+};
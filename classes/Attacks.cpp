@@ -0,0 +1,150 @@
+#include "Attacks.h"
+#include <mutex>
+
+namespace Attacks
+{
+    Bitboard PawnAttacks[2][64];
+    Bitboard KnightAttacks[64];
+    Bitboard KingAttacks[64];
+    Magic BishopMagics[64];
+    Magic RookMagics[64];
+    Bitboard BetweenBB[64][64];
+    Bitboard LineBB[64][64];
+
+    namespace
+    {
+        const int BishopDirections[4][2] = {{1, 1}, {-1, 1}, {1, -1}, {-1, -1}};
+        const int RookDirections[4][2] = {{1, 0}, {-1, 0}, {0, 1}, {0, -1}};
+
+        Bitboard offsetsToBB(int square, const int offsets[][2], int count)
+        {
+            Bitboard result = 0;
+            for (int i = 0; i < count; i++) {
+                int x = fileOf(square) + offsets[i][0];
+                int y = rankOf(square) + offsets[i][1];
+                if (x >= 0 && x < 8 && y >= 0 && y < 8) {
+                    result |= squareBB(squareOf(x, y));
+                }
+            }
+            return result;
+        }
+
+        // walk each ray until the edge of the board or the first blocker (blocker included)
+        Bitboard slidingAttacks(int square, Bitboard occupied, const int directions[4][2])
+        {
+            Bitboard attacks = 0;
+            for (int d = 0; d < 4; d++) {
+                int x = fileOf(square) + directions[d][0];
+                int y = rankOf(square) + directions[d][1];
+                while (x >= 0 && x < 8 && y >= 0 && y < 8) {
+                    Bitboard b = squareBB(squareOf(x, y));
+                    attacks |= b;
+                    if (occupied & b) {
+                        break;
+                    }
+                    x += directions[d][0];
+                    y += directions[d][1];
+                }
+            }
+            return attacks;
+        }
+
+        Bitboard BishopTable[0x1480];
+        Bitboard RookTable[0x19000];
+
+        // xorshift64*, fixed seed so the same magics are found on every run
+        Bitboard randomBB(Bitboard &state)
+        {
+            state ^= state >> 12;
+            state ^= state << 25;
+            state ^= state >> 27;
+            return state * 2685821657736338717ULL;
+        }
+
+        // find a magic for every square by trial and error, filling the attack table slices as we go
+        void initMagics(Magic magics[64], Bitboard *table, const int directions[4][2])
+        {
+            Bitboard occupancy[4096];
+            Bitboard reference[4096];
+            int epoch[4096] = {};
+            int attempt = 0;
+            Bitboard seed = 0x9E3779B97F4A7C15ULL;
+
+            for (int square = 0; square < 64; square++) {
+                Magic &m = magics[square];
+
+                // board edges don't affect the attack set unless the slider sits on them
+                Bitboard edges = ((Rank1BB | Rank8BB) & ~(Rank1BB << (8 * rankOf(square)))) |
+                                 ((FileABB | FileHBB) & ~(FileABB << fileOf(square)));
+                m.mask = slidingAttacks(square, 0, directions) & ~edges;
+                m.shift = 64 - popCount(m.mask);
+                m.attacks = square == 0 ? table : magics[square - 1].attacks + (1 << (64 - magics[square - 1].shift));
+
+                // enumerate every subset of the mask (Carry-Rippler) with its true attack set
+                int size = 0;
+                Bitboard subset = 0;
+                do {
+                    occupancy[size] = subset;
+                    reference[size] = slidingAttacks(square, subset, directions);
+                    size++;
+                    subset = (subset - m.mask) & m.mask;
+                } while (subset);
+
+                for (int i = 0; i < size;) {
+                    do {
+                        m.magic = randomBB(seed) & randomBB(seed) & randomBB(seed);
+                    } while (popCount((m.magic * m.mask) >> 56) < 6);
+
+                    // a magic is good when no two subsets with different attacks share an index
+                    attempt++;
+                    for (i = 0; i < size; i++) {
+                        unsigned index = m.index(occupancy[i]);
+                        if (epoch[index] < attempt) {
+                            epoch[index] = attempt;
+                            m.attacks[index] = reference[i];
+                        } else if (m.attacks[index] != reference[i]) {
+                            break;
+                        }
+                    }
+                }
+            }
+        }
+    }
+
+    void init()
+    {
+        static std::once_flag initialized;
+        std::call_once(initialized, [] {
+            const int knightOffsets[8][2] = {{2,1}, {2,-1}, {-2,1}, {-2,-1}, {1,2}, {1,-2}, {-1,2}, {-1,-2}};
+            const int kingOffsets[8][2] = {{1,0}, {-1,0}, {0,1}, {0,-1}, {1,1}, {-1,1}, {1,-1}, {-1,-1}};
+            const int whitePawnOffsets[2][2] = {{-1, 1}, {1, 1}};
+            const int blackPawnOffsets[2][2] = {{-1, -1}, {1, -1}};
+
+            for (int square = 0; square < 64; square++) {
+                KnightAttacks[square] = offsetsToBB(square, knightOffsets, 8);
+                KingAttacks[square] = offsetsToBB(square, kingOffsets, 8);
+                PawnAttacks[0][square] = offsetsToBB(square, whitePawnOffsets, 2);
+                PawnAttacks[1][square] = offsetsToBB(square, blackPawnOffsets, 2);
+            }
+
+            initMagics(BishopMagics, BishopTable, BishopDirections);
+            initMagics(RookMagics, RookTable, RookDirections);
+
+            for (int a = 0; a < 64; a++) {
+                for (int b = 0; b < 64; b++) {
+                    BetweenBB[a][b] = 0;
+                    LineBB[a][b] = 0;
+                    if (a == b) {
+                        continue;
+                    }
+                    for (const auto *directions : {BishopDirections, RookDirections}) {
+                        if (slidingAttacks(a, 0, directions) & squareBB(b)) {
+                            LineBB[a][b] = (slidingAttacks(a, 0, directions) & slidingAttacks(b, 0, directions)) | squareBB(a) | squareBB(b);
+                            BetweenBB[a][b] = slidingAttacks(a, squareBB(b), directions) & slidingAttacks(b, squareBB(a), directions);
+                        }
+                    }
+                }
+            }
+        });
+    }
+}
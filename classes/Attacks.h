@@ -0,0 +1,53 @@
+#pragma once
+
+#include "Bitboard.h"
+
+//
+// precomputed attack sets for every piece type
+// Attacks::init() must be called once before any lookups
+//
+namespace Attacks
+{
+    void init();
+
+    // fancy magic bitboard entry: the relevant occupancy of a slider's rays is
+    // hashed by a multiply and shift into its own slice of a shared attack table
+    struct Magic
+    {
+        Bitboard mask;
+        Bitboard magic;
+        Bitboard *attacks;
+        unsigned shift;
+
+        unsigned index(Bitboard occupied) const { return static_cast<unsigned>(((occupied & mask) * magic) >> shift); }
+    };
+
+    extern Bitboard PawnAttacks[2][64];
+    extern Bitboard KnightAttacks[64];
+    extern Bitboard KingAttacks[64];
+    extern Magic BishopMagics[64];
+    extern Magic RookMagics[64];
+    extern Bitboard BetweenBB[64][64];
+    extern Bitboard LineBB[64][64];
+
+    inline Bitboard pawn(int color, int square) { return PawnAttacks[color][square]; }
+    inline Bitboard knight(int square) { return KnightAttacks[square]; }
+    inline Bitboard king(int square) { return KingAttacks[square]; }
+
+    inline Bitboard bishop(int square, Bitboard occupied)
+    {
+        const Magic &m = BishopMagics[square];
+        return m.attacks[m.index(occupied)];
+    }
+    inline Bitboard rook(int square, Bitboard occupied)
+    {
+        const Magic &m = RookMagics[square];
+        return m.attacks[m.index(occupied)];
+    }
+    inline Bitboard queen(int square, Bitboard occupied) { return bishop(square, occupied) | rook(square, occupied); }
+
+    // squares strictly between two aligned squares, 0 if they don't share a line
+    inline Bitboard between(int a, int b) { return BetweenBB[a][b]; }
+    // the whole rank, file or diagonal through two aligned squares, 0 if they don't share one
+    inline Bitboard line(int a, int b) { return LineBB[a][b]; }
+}
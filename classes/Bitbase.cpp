@@ -0,0 +1,397 @@
+#include "Bitbase.h"
+#include "Attacks.h"
+#include "Threading.h"
+#include <algorithm>
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace Bitbase
+{
+    namespace
+    {
+        enum Ending
+        {
+            KPK,
+            KRK,
+            KQK,
+            KBNK,
+            EndingCount
+        };
+
+        // the stronger side is white in the tables; probes flip the board when it isn't
+        struct Table
+        {
+            int pieces[2];      // white's pieces besides the king, NoPiece if there is only one
+            int pieceCount;
+            size_t size = 0;
+            // by position: 0 for a draw (or an illegal position), otherwise plies to mate + 1
+            std::unique_ptr<std::atomic<uint8_t>[]> values;
+        };
+
+        Table Tables[EndingCount] = {
+            { { Pawn, NoPiece }, 1, 0, nullptr },
+            { { Rook, NoPiece }, 1, 0, nullptr },
+            { { Queen, NoPiece }, 1, 0, nullptr },
+            { { Bishop, Knight }, 2, 0, nullptr },
+        };
+        std::atomic<bool> Ready{false};
+
+        // a table position: the side to move (White is the stronger side), both kings and white's pieces
+        struct Squares
+        {
+            int stm;
+            int wk;
+            int bk;
+            int p[2];
+        };
+
+        size_t indexOf(const Table &table, const Squares &s)
+        {
+            size_t index = (static_cast<size_t>(s.stm) * 64 + s.wk) * 64 + s.bk;
+            for (int i = 0; i < table.pieceCount; i++) {
+                index = index * 64 + s.p[i];
+            }
+            return index;
+        }
+
+        Squares squaresOf(const Table &table, size_t index)
+        {
+            Squares s;
+            s.p[0] = s.p[1] = -1;
+            for (int i = table.pieceCount - 1; i >= 0; i--) {
+                s.p[i] = static_cast<int>(index & 63);
+                index >>= 6;
+            }
+            s.bk = static_cast<int>(index & 63);
+            s.wk = static_cast<int>((index >> 6) & 63);
+            s.stm = static_cast<int>(index >> 12);
+            return s;
+        }
+
+        Bitboard occupancyOf(const Table &table, const Squares &s)
+        {
+            Bitboard occupied = squareBB(s.wk) | squareBB(s.bk);
+            for (int i = 0; i < table.pieceCount; i++) {
+                occupied |= squareBB(s.p[i]);
+            }
+            return occupied;
+        }
+
+        Bitboard pieceAttacks(int piece, int square, Bitboard occupied)
+        {
+            switch (piece) {
+            case Pawn: return Attacks::pawn(White, square);
+            case Knight: return Attacks::knight(square);
+            case Bishop: return Attacks::bishop(square, occupied);
+            case Rook: return Attacks::rook(square, occupied);
+            case Queen: return Attacks::queen(square, occupied);
+            default: return 0;
+            }
+        }
+
+        // a piece doesn't attack its own square, so a white piece shows up here only if it is defended
+        Bitboard whiteAttacks(const Table &table, const Squares &s, Bitboard occupied)
+        {
+            Bitboard attacks = Attacks::king(s.wk);
+            for (int i = 0; i < table.pieceCount; i++) {
+                attacks |= pieceAttacks(table.pieces[i], s.p[i], occupied);
+            }
+            return attacks;
+        }
+
+        // whether a game can reach the position: every piece on its own square, no pawn on
+        // a back rank, the kings apart and the side that just moved not left in check
+        bool isLegal(const Table &table, const Squares &s)
+        {
+            if (distance(s.wk, s.bk) <= 1) {
+                return false;
+            }
+            Bitboard occupied = squareBB(s.wk) | squareBB(s.bk);
+            for (int i = 0; i < table.pieceCount; i++) {
+                if (occupied & squareBB(s.p[i])) {
+                    return false;
+                }
+                if (table.pieces[i] == Pawn && (rankOf(s.p[i]) == 0 || rankOf(s.p[i]) == 7)) {
+                    return false;
+                }
+                occupied |= squareBB(s.p[i]);
+            }
+            // black has only its king, which can't give check
+            return s.stm == Black || !(whiteAttacks(table, s, occupied) & squareBB(s.bk));
+        }
+
+        // counter for black to move positions no move leads out of (stalemate, illegal)
+        constexpr uint8_t NoMoves = 255;
+        // added to the counter when black can capture a piece, which draws, so it never runs out
+        constexpr int EscapeMoves = 100;
+
+        class Generator
+        {
+        public:
+            Generator(Table &table, int threads) : _table(table), _threads(threads) {}
+
+            void run()
+            {
+                _table.size = size_t(2) << (6 * (2 + _table.pieceCount));
+                _table.values.reset(new std::atomic<uint8_t>[_table.size]);
+                _counters.reset(new std::atomic<uint8_t>[_table.size]);
+
+                std::vector<std::vector<uint32_t>> mates(_threads);
+                parallelFor(_threads, _table.size, [&](int t, size_t begin, size_t end) {
+                    for (size_t index = begin; index < end; index++) {
+                        initPosition(static_cast<uint32_t>(index), mates[t]);
+                    }
+                });
+                std::vector<uint32_t> frontier = merge(mates);
+                std::vector<std::vector<uint32_t>> promotions = promotionWins();
+
+                // each pass resolves the positions one ply further from mate than the last
+                for (int ply = 0; ; ply++) {
+                    if (ply < static_cast<int>(promotions.size())) {
+                        for (uint32_t index : promotions[ply]) {
+                            uint8_t expected = 0;
+                            if (_table.values[index].compare_exchange_strong(expected, static_cast<uint8_t>(ply + 1))) {
+                                frontier.push_back(index);
+                            }
+                        }
+                    }
+                    if (frontier.empty() && ply >= static_cast<int>(promotions.size())) {
+                        break;
+                    }
+
+                    std::vector<std::vector<uint32_t>> next(_threads);
+                    parallelFor(_threads, frontier.size(), [&](int t, size_t begin, size_t end) {
+                        for (size_t i = begin; i < end; i++) {
+                            resolvePredecessors(frontier[i], ply + 1, next[t]);
+                        }
+                    });
+                    frontier = merge(next);
+                }
+                _counters.reset();
+            }
+
+        private:
+            static std::vector<uint32_t> merge(std::vector<std::vector<uint32_t>> &parts)
+            {
+                std::vector<uint32_t> merged;
+                for (auto &part : parts) {
+                    merged.insert(merged.end(), part.begin(), part.end());
+                }
+                return merged;
+            }
+
+            // mark mates, and count black's moves everywhere else
+            void initPosition(uint32_t index, std::vector<uint32_t> &mates)
+            {
+                _table.values[index].store(0, std::memory_order_relaxed);
+                _counters[index].store(NoMoves, std::memory_order_relaxed);
+
+                Squares s = squaresOf(_table, index);
+                if (s.stm == White || !isLegal(_table, s)) {
+                    return;
+                }
+
+                Bitboard occupied = occupancyOf(_table, s);
+                // sliders see through the king, so it can't step back along a checking line
+                Bitboard attacked = whiteAttacks(_table, s, occupied & ~squareBB(s.bk));
+                int moves = 0;
+                bool escape = false;
+                Bitboard targets = Attacks::king(s.bk) & ~attacked;
+                while (targets) {
+                    int to = popLsb(targets);
+                    if (occupied & squareBB(to)) {
+                        escape = true;
+                    } else {
+                        moves++;
+                    }
+                }
+
+                if (moves == 0 && !escape) {
+                    if (attacked & squareBB(s.bk)) {
+                        _table.values[index].store(1, std::memory_order_relaxed);
+                        mates.push_back(index);
+                    }
+                    return;
+                }
+                _counters[index].store(static_cast<uint8_t>(moves + (escape ? EscapeMoves : 0)), std::memory_order_relaxed);
+            }
+
+            // index was resolved at ply - 1; positions one move before it are ply from mate
+            void resolvePredecessors(uint32_t index, int ply, std::vector<uint32_t> &resolved)
+            {
+                Squares s = squaresOf(_table, index);
+                Bitboard occupied = occupancyOf(_table, s);
+                uint8_t value = static_cast<uint8_t>(ply + 1);
+
+                if (s.stm == Black) {
+                    // black is lost here, so any white move leading here wins
+                    Squares before = s;
+                    before.stm = White;
+                    auto markWin = [&] {
+                        // most predecessors are reached again and again, so check that first
+                        uint32_t previous = static_cast<uint32_t>(indexOf(_table, before));
+                        if (_table.values[previous].load(std::memory_order_relaxed) != 0 || !isLegal(_table, before)) {
+                            return;
+                        }
+                        uint8_t expected = 0;
+                        if (_table.values[previous].compare_exchange_strong(expected, value)) {
+                            resolved.push_back(previous);
+                        }
+                    };
+
+                    Bitboard froms = Attacks::king(s.wk) & ~occupied;
+                    while (froms) {
+                        before.wk = popLsb(froms);
+                        markWin();
+                    }
+                    before.wk = s.wk;
+
+                    for (int i = 0; i < _table.pieceCount; i++) {
+                        int square = s.p[i];
+                        if (_table.pieces[i] == Pawn) {
+                            // pawns only come from behind, two squares from their starting rank
+                            froms = 0;
+                            if (rankOf(square) >= 2 && !(occupied & squareBB(square - 8))) {
+                                froms |= squareBB(square - 8);
+                                if (rankOf(square) == 3 && !(occupied & squareBB(square - 16))) {
+                                    froms |= squareBB(square - 16);
+                                }
+                            }
+                        } else {
+                            froms = pieceAttacks(_table.pieces[i], square, occupied) & ~occupied;
+                        }
+                        while (froms) {
+                            before.p[i] = popLsb(froms);
+                            markWin();
+                        }
+                        before.p[i] = square;
+                    }
+                } else {
+                    // white wins here: a black position is lost once every one of its moves leads to a win
+                    Squares before = s;
+                    before.stm = Black;
+                    Bitboard froms = Attacks::king(s.bk) & ~occupied;
+                    while (froms) {
+                        before.bk = popLsb(froms);
+                        if (distance(before.bk, s.wk) <= 1) {
+                            continue;
+                        }
+                        uint32_t previous = static_cast<uint32_t>(indexOf(_table, before));
+                        if (_counters[previous].fetch_sub(1, std::memory_order_relaxed) == 1) {
+                            _table.values[previous].store(value, std::memory_order_relaxed);
+                            resolved.push_back(previous);
+                        }
+                    }
+                }
+            }
+
+            // KPK leaves the table by promoting: those wins come from the queen and rook tables,
+            // bucketed by the ply they resolve at
+            std::vector<std::vector<uint32_t>> promotionWins()
+            {
+                std::vector<std::vector<uint32_t>> wins;
+                if (_table.pieces[0] != Pawn) {
+                    return wins;
+                }
+                for (int wk = 0; wk < 64; wk++) {
+                    for (int bk = 0; bk < 64; bk++) {
+                        for (int pawn = 48; pawn < 56; pawn++) {
+                            Squares s = { White, wk, bk, { pawn, -1 } };
+                            if (!isLegal(_table, s) || wk == pawn + 8 || bk == pawn + 8) {
+                                continue;
+                            }
+                            int best = 0;
+                            for (int ending : { KQK, KRK }) {
+                                const Table &promoted = Tables[ending];
+                                Squares after = { Black, wk, bk, { pawn + 8, -1 } };
+                                int value = isLegal(promoted, after) ? promoted.values[indexOf(promoted, after)].load() : 0;
+                                if (value && (!best || value < best)) {
+                                    best = value;
+                                }
+                            }
+                            if (best) {
+                                // mated in best - 1 plies after the promotion
+                                if (static_cast<int>(wins.size()) <= best) {
+                                    wins.resize(best + 1);
+                                }
+                                wins[best].push_back(static_cast<uint32_t>(indexOf(_table, s)));
+                            }
+                        }
+                    }
+                }
+                return wins;
+            }
+
+            Table &_table;
+            int _threads;
+            // black to move positions: moves not yet known to lose
+            std::unique_ptr<std::atomic<uint8_t>[]> _counters;
+        };
+    }
+
+    void init()
+    {
+        static std::once_flag initialized;
+        std::call_once(initialized, [] {
+            Attacks::init();
+            int threads = std::max(1, static_cast<int>(std::thread::hardware_concurrency()));
+            // KPK needs the queen and rook tables for its promotions, so it goes after them
+            for (Ending ending : { KQK, KRK, KBNK, KPK }) {
+                Generator(Tables[ending], threads).run();
+            }
+            Ready.store(true, std::memory_order_release);
+        });
+    }
+
+    bool ready()
+    {
+        return Ready.load(std::memory_order_acquire);
+    }
+
+    bool probe(const ChessPosition &position, ProbeResult &result)
+    {
+        if (!ready()) {
+            return false;
+        }
+        // the tables know nothing of castling
+        int count = popCount(position.occupied());
+        if (count < 3 || count > MaxPieces || position.castlingRights() != 0) {
+            return false;
+        }
+
+        for (int strong : { White, Black }) {
+            int weak = strong ^ 1;
+            if (position.occupancy(weak) != position.pieces(weak, King)) {
+                continue;
+            }
+            int pieceCount = popCount(position.occupancy(strong)) - 1;
+            for (const Table &table : Tables) {
+                if (table.pieceCount != pieceCount) {
+                    continue;
+                }
+                // the tables have the stronger side as white, so flip the board if it is black
+                int flip = strong == White ? 0 : 56;
+                Squares s = { position.sideToMove() == strong ? White : Black,
+                              position.kingSquare(strong) ^ flip, position.kingSquare(weak) ^ flip, { -1, -1 } };
+                bool matches = true;
+                for (int i = 0; i < table.pieceCount && matches; i++) {
+                    Bitboard pieces = position.pieces(strong, table.pieces[i]);
+                    matches = popCount(pieces) == 1;
+                    s.p[i] = matches ? lsb(pieces) ^ flip : -1;
+                }
+                if (!matches) {
+                    continue;
+                }
+
+                int value = table.values[indexOf(table, s)].load(std::memory_order_relaxed);
+                result.wdl = value == 0 ? 0 : (s.stm == White ? 1 : -1);
+                result.plies = value == 0 ? 0 : value - 1;
+                return true;
+            }
+        }
+        return false;
+    }
+}
@@ -0,0 +1,30 @@
+#pragma once
+
+#include "ChessPosition.h"
+
+//
+// endgame bitbases for king and pawn, rook, queen or bishop and knight against a lone
+// king, built by retrograde analysis: mates are found first, then every position that
+// reaches one in one more ply, and so on until nothing changes. Whatever is left over is
+// a draw. Each entry holds the distance to mate, so the search plays these out perfectly.
+//
+// Bitbase::init() builds all four on a few threads; probing before it has finished
+// just reports the position as not covered.
+//
+namespace Bitbase
+{
+    // the most pieces, kings included, of any covered ending
+    inline constexpr int MaxPieces = 4;
+
+    struct ProbeResult
+    {
+        int wdl;        // 1 the side to move wins, 0 draw, -1 it loses
+        int plies;      // to mate, 0 for a draw
+    };
+
+    void init();
+    bool ready();
+
+    // false if the position isn't one of the covered endings
+    bool probe(const ChessPosition &position, ProbeResult &result);
+}
@@ -0,0 +1,40 @@
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdlib>
+#include <bit>
+
+// 64-bit set of squares, bit index = y * 8 + x (a1 = 0, h8 = 63)
+using Bitboard = uint64_t;
+
+constexpr Bitboard FileABB = 0x0101010101010101ULL;
+constexpr Bitboard FileHBB = FileABB << 7;
+constexpr Bitboard Rank1BB = 0xFFULL;
+constexpr Bitboard Rank2BB = Rank1BB << 8;
+constexpr Bitboard Rank4BB = Rank1BB << 24;
+constexpr Bitboard Rank5BB = Rank1BB << 32;
+constexpr Bitboard Rank7BB = Rank1BB << 48;
+constexpr Bitboard Rank8BB = Rank1BB << 56;
+
+inline constexpr int squareOf(int x, int y) { return y * 8 + x; }
+inline constexpr int fileOf(int square) { return square & 7; }
+inline constexpr int rankOf(int square) { return square >> 3; }
+inline constexpr Bitboard squareBB(int square) { return 1ULL << square; }
+
+// king steps between two squares
+inline int distance(int a, int b)
+{
+    return std::max(std::abs(fileOf(a) - fileOf(b)), std::abs(rankOf(a) - rankOf(b)));
+}
+
+inline int popCount(Bitboard b) { return std::popcount(b); }
+inline int lsb(Bitboard b) { return std::countr_zero(b); }
+
+// return the lowest set square and clear it from the board
+inline int popLsb(Bitboard &b)
+{
+    int square = lsb(b);
+    b &= b - 1;
+    return square;
+}
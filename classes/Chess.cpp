@@ -1,13 +1,26 @@
 #include "Chess.h"
+#include "Attacks.h"
+#include "Bitbase.h"
 #include <limits>
 #include <cmath>
 #include <cctype>
 #include <iostream>
 #include <algorithm>
+#include <thread>
+
+namespace
+{
+    // Bit gameTag for a position piece code: white 0..6, black 128+0..6 (index by ChessPiece enum)
+    int gameTagForPiece(int code)
+    {
+        return (pieceColorOf(code) == White ? 0 : 128) + pieceTypeOf(code);
+    }
+}
 
 Chess::Chess()
 {
     _grid = new Grid(8, 8);
+    Attacks::init();
 }
 
 Chess::~Chess()
@@ -53,6 +66,22 @@ void Chess::setUpBoard()
     setNumberOfPlayers(2);
     _gameOptions.rowX = 8;
     _gameOptions.rowY = 8;
+    // think for up to half a second, stopping earlier only if a cap is set
+    _gameOptions.AIMoveTimeMs = 500;
+    // search on every core (Lazy SMP); the workers can't be replaced under a running search
+    int threads = std::max(1, static_cast<int>(std::thread::hardware_concurrency()));
+    if (_search.threads() != threads) {
+        cancelThinking();
+        _search.setThreads(threads);
+    }
+    // evaluate with the network if one ships in resources, the hand written evaluation otherwise
+    if (!_search.hasNetwork()) {
+        _search.loadNetwork("resources/chess.nnue");
+    }
+    // the search ignores the endgame tables until they are built, so don't wait for them
+    if (!_bitbases.valid()) {
+        _bitbases = std::async(std::launch::async, Bitbase::init);
+    }
 
     _grid->initializeChessSquares(pieceSize, "boardsquare.png");
     FENtoBoard("rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR");
@@ -61,62 +90,18 @@ void Chess::setUpBoard()
 }
 
 void Chess::FENtoBoard(const std::string& fen) {
-    // Parse board portion of FEN (supports board-only or full FEN with spaces)
-    // Clear existing pieces first
+    // Parse into a new position (supports board-only or full FEN with spaces),
+    // then create the Bits from it. A FEN that doesn't parse leaves the game as it was
+    ChessPosition position;
+    if (!position.setFromFEN(fen)) {
+        return;
+    }
+    cancelThinking();
     _grid->forEachSquare([](ChessSquare* square, int x, int y) {
         square->destroyBit();
     });
-
-    // Extract the first field (piece placement)
-    std::string placement = fen;
-    size_t spacePos = fen.find(' ');
-    if (spacePos != std::string::npos) {
-        placement = fen.substr(0, spacePos);
-    }
-
-    int y = 7; // FEN starts at rank 8 (top) -> internal y = 7
-    int x = 0;
-    for (size_t i = 0; i < placement.size() && y >= 0; ++i) {
-        char c = placement[i];
-        if (c == '/') {
-            y -= 1;
-            x = 0;
-            continue;
-        }
-        if (std::isdigit(static_cast<unsigned char>(c))) {
-            x += (c - '0');
-            continue;
-        }
-
-        // Piece letter
-        bool isWhite = std::isupper(static_cast<unsigned char>(c)) != 0;
-        char lower = (char)std::tolower(static_cast<unsigned char>(c));
-        ChessPiece piece = NoPiece;
-        switch (lower) {
-            case 'p': piece = Pawn; break;
-            case 'n': piece = Knight; break;
-            case 'b': piece = Bishop; break;
-            case 'r': piece = Rook; break;
-            case 'q': piece = Queen; break;
-            case 'k': piece = King; break;
-            default: piece = NoPiece; break;
-        }
-        if (piece != NoPiece && x >= 0 && x < 8 && y >= 0 && y < 8) {
-            int playerNumber = isWhite ? 0 : 1;
-            ChessSquare* sq = _grid->getSquare(x, y);
-            if (sq) {
-                Bit* bit = PieceForPlayer(playerNumber, piece);
-                if (bit) {
-                    // Set gameTag: white 0..6, black 128+0..6 (index by ChessPiece enum)
-                    int tag = (isWhite ? 0 : 128) + static_cast<int>(piece);
-                    bit->setGameTag(tag);
-                    bit->setPosition(sq->getPosition());
-                    sq->setBit(bit);
-                }
-            }
-            x += 1;
-        }
-    }
+    _position = position;
+    syncGridWithPosition();
 }
 
 std::string Chess::generateFENFromBoard() {
@@ -159,185 +144,83 @@ std::string Chess::generateFENFromBoard() {
 }
 
 void Chess::rebuildBoardFromFEN() {
-    // Use the same format as stateString() for consistency
-    std::string currentState = stateString();
-    
-    // Clear existing pieces first
+    cancelThinking();
+    // The position is authoritative, so rebuild every Bit from it
     _grid->forEachSquare([](ChessSquare* square, int x, int y) {
         square->destroyBit();
     });
-    
-    // Rebuild from the state string (64-character format)
-    for (int y = 0; y < 8; y++) {
-        for (int x = 0; x < 8; x++) {
-            int index = y * 8 + x;
-            if (index < currentState.length()) {
-                char c = currentState[index];
-                if (c != '0') {  // '0' represents empty square
-                    // Determine piece type and color from character
-                    bool isWhite = std::isupper(static_cast<unsigned char>(c)) != 0;
-                    char lower = (char)std::tolower(static_cast<unsigned char>(c));
-                    
-                    ChessPiece piece = NoPiece;
-                    switch (lower) {
-                        case 'p': piece = Pawn; break;
-                        case 'n': piece = Knight; break;
-                        case 'b': piece = Bishop; break;
-                        case 'r': piece = Rook; break;
-                        case 'q': piece = Queen; break;
-                        case 'k': piece = King; break;
-                        default: piece = NoPiece; break;
-                    }
-                    
-                    if (piece != NoPiece) {
-                        int playerNumber = isWhite ? 0 : 1;
-                        ChessSquare* sq = _grid->getSquare(x, y);
-                        if (sq) {
-                            Bit* bit = PieceForPlayer(playerNumber, piece);
-                            if (bit) {
-                                // Set gameTag: white 0..6, black 128+0..6 (index by ChessPiece enum)
-                                int tag = (isWhite ? 0 : 128) + static_cast<int>(piece);
-                                bit->setGameTag(tag);
-                                bit->setPosition(sq->getPosition());
-                                sq->setBit(bit);
-                            }
-                        }
-                    }
-                }
-            }
-        }
-    }
+    syncGridWithPosition();
 }
 
-void Chess::bitMovedFromTo(Bit &bit, BitHolder &src, BitHolder &dst) {
-    // Get piece type and color
-    int pieceType = bit.gameTag() & 0x7F;
-    bool isWhite = (bit.gameTag() & 0x80) == 0;
+void Chess::syncGridWithPosition()
+{
+    // Only squares whose Bit no longer matches the position are touched
+    _grid->forEachSquare([&](ChessSquare* square, int x, int y) {
+        int code = _position.pieceAt(squareOf(x, y));
+        Bit* bit = square->bit();
+        if (bit && code && bit->gameTag() == gameTagForPiece(code)) {
+            return;
+        }
+        if (bit) {
+            square->destroyBit();
+        }
+        if (code) {
+            Bit* newBit = PieceForPlayer(pieceColorOf(code), static_cast<ChessPiece>(pieceTypeOf(code)));
+            newBit->setGameTag(gameTagForPiece(code));
+            newBit->setPosition(square->getPosition());
+            square->setBit(newBit);
+        }
+    });
+}
 
-    // Handle En Passant Capture
-    if (pieceType == Pawn) {
-        ChessSquare* dstSquare = dynamic_cast<ChessSquare*>(&dst);
-        if (dstSquare && _enPassantColumn != -1 && 
-            dstSquare->getColumn() == _enPassantColumn && 
-            dstSquare->getRow() == _enPassantTargetRow) {
-            
-            ChessSquare* capturedSquare = _grid->getSquare(_enPassantColumn, _enPassantRow);
-            if (capturedSquare) {
-                capturedSquare->destroyBit();
-            }
+ChessMove Chess::moveForSquares(ChessSquare& src, ChessSquare& dst) const
+{
+    MoveList moves;
+    _position.generateLegalMoves(moves);
+    // Promotions are generated queen first, so the UI always promotes to a queen
+    for (ChessMove move : moves) {
+        if (move.from() == src.getSquareIndex() && move.to() == dst.getSquareIndex()) {
+            return move;
         }
     }
+    return ChessMove();
+}
 
-    // Update En Passant State for next turn
-    int nextEnPassantCol = -1;
-    int nextEnPassantRow = -1;
-    int nextEnPassantTargetRow = -1;
+std::pair<ChessSquare*, ChessSquare*> Chess::squaresForMove(ChessMove move)
+{
+    return { _grid->getSquare(fileOf(move.from()), rankOf(move.from())),
+             _grid->getSquare(fileOf(move.to()), rankOf(move.to())) };
+}
 
-    if (pieceType == Pawn) {
-        ChessSquare* srcSquare = dynamic_cast<ChessSquare*>(&src);
-        ChessSquare* dstSquare = dynamic_cast<ChessSquare*>(&dst);
-        if (srcSquare && dstSquare && abs(srcSquare->getRow() - dstSquare->getRow()) == 2) {
-            nextEnPassantCol = dstSquare->getColumn();
-            nextEnPassantRow = dstSquare->getRow();
-            nextEnPassantTargetRow = (srcSquare->getRow() + dstSquare->getRow()) / 2;
-        }
+void Chess::commitMove(ChessMove move)
+{
+    // Carry the moving Bit across so it keeps its sprite, then let the sync
+    // take care of captures, en passant, castling rooks and promotion
+    auto [fromSquare, toSquare] = squaresForMove(move);
+    Bit* piece = fromSquare->releaseBit();
+    toSquare->destroyBit();
+    toSquare->setBit(piece);
+    if (piece) {
+        piece->setPosition(toSquare->getPosition());
     }
 
-    _enPassantColumn = nextEnPassantCol;
-    _enPassantRow = nextEnPassantRow;
-    _enPassantTargetRow = nextEnPassantTargetRow;
-    
-    // Track king and rook movements
-    if (pieceType == King) {
-        if (isWhite) {
-            _whiteKingMoved = true;
-            _castlingRights[0] = false; // White kingside
-            _castlingRights[1] = false; // White queenside
-        } else {
-            _blackKingMoved = true;
-            _castlingRights[2] = false; // Black kingside
-            _castlingRights[3] = false; // Black queenside
-        }
-    } 
-    // Track rook movements
-    else if (pieceType == Rook) {
-        ChessSquare* srcSquare = dynamic_cast<ChessSquare*>(&src);
-        if (srcSquare) {
-            int x = srcSquare->getColumn();
-            int y = srcSquare->getRow();
-            
-            if (isWhite) {
-                if (x == 0 && y == 0) _whiteQueensideRookMoved = true;
-                else if (x == 7 && y == 0) _whiteKingsideRookMoved = true;
-            } else {
-                if (x == 0 && y == 7) _blackQueensideRookMoved = true;
-                else if (x == 7 && y == 7) _blackKingsideRookMoved = true;
-            }
-            
-            // Update castling rights if a rook moves from its starting position
-            if (y == (isWhite ? 0 : 7)) {
-                if (x == 0) _castlingRights[isWhite ? 1 : 3] = false; // Queenside
-                else if (x == 7) _castlingRights[isWhite ? 0 : 2] = false; // Kingside
-            }
-        }
-    }
-    
-    // Handle Pawn Promotion
-    if (pieceType == Pawn) {
-        ChessSquare* dstSquare = dynamic_cast<ChessSquare*>(&dst);
-        if (dstSquare) {
-            int row = dstSquare->getRow();
-            // White promotes at row 7, Black at row 0
-            if ((isWhite && row == 7) || (!isWhite && row == 0)) {
-                // Promote to Queen
-                int newTag = (isWhite ? 0 : 128) + Queen;
-                bit.setGameTag(newTag);
-                
-                std::string spritePath = std::string("") + (isWhite ? "w_" : "b_") + "queen.png";
-                bit.LoadTextureFromFile(spritePath.c_str());
-                bit.setSize(pieceSize, pieceSize);
-            }
-        }
-    }
+    _position.makeMove(move);
+    syncGridWithPosition();
+}
 
-    // Handle castling - move the rook
+void Chess::bitMovedFromTo(Bit &bit, BitHolder &src, BitHolder &dst) {
+    // The Bit has already been dropped on dst; apply the move to the position
+    // and resync the board for the side effects of special moves
     ChessSquare* srcSquare = dynamic_cast<ChessSquare*>(&src);
     ChessSquare* dstSquare = dynamic_cast<ChessSquare*>(&dst);
-    
-    if (!srcSquare || !dstSquare) {
-        _moveCount++;
-        endTurn();
-        return;
-    }
-    
-    if (pieceType == King && 
-        abs(srcSquare->getColumn() - dstSquare->getColumn()) == 2) {
-        // This is a castling move
-        bool kingside = (dstSquare->getColumn() > srcSquare->getColumn());
-        int row = isWhite ? 0 : 7;
-        
-        // Get rook squares
-        int rookFromCol = kingside ? 7 : 0;
-        int rookToCol = kingside ? 5 : 3;
-        
-        ChessSquare* rookSquare = _grid->getSquare(rookFromCol, row);
-        ChessSquare* newRookSquare = _grid->getSquare(rookToCol, row);
-        
-        // Verify all squares exist and rook is present
-        if (rookSquare && newRookSquare && rookSquare->bit()) {
-            Bit* rook = rookSquare->bit();
-            
-            // Verify it's actually a rook
-            int rookType = rook->gameTag() & 0x7F;
-            if (rookType == Rook) {
-                // Move the rook safely using releaseBit() to avoid deletion
-                rookSquare->releaseBit(); 
-                newRookSquare->setBit(rook);
-                rook->setPosition(newRookSquare->getPosition());
-            }
-        }
+    cancelThinking();
+
+    ChessMove move = (srcSquare && dstSquare) ? moveForSquares(*srcSquare, *dstSquare) : ChessMove();
+    if (!move.isNull()) {
+        _position.makeMove(move);
     }
-    
+    syncGridWithPosition();
+
     // Increment move count for manual moves too
     _moveCount++;
     
@@ -365,218 +248,21 @@ bool Chess::canBitMoveFrom(Bit &bit, BitHolder &src)
 
 bool Chess::canBitMoveFromTo(Bit &bit, BitHolder &src, BitHolder &dst)
 {
-    if (!canBitMoveFromToPseudo(bit, src, dst)) {
-        return false;
-    }
-
     ChessSquare* srcSquare = dynamic_cast<ChessSquare*>(&src);
     ChessSquare* dstSquare = dynamic_cast<ChessSquare*>(&dst);
     if (!srcSquare || !dstSquare) return false;
 
-    // Check if the move puts/leaves the king in check
-    // Note: We need to pass the player number of the moving piece
-    int playerNumber = (bit.gameTag() & 128) ? 1 : 0;
-    if (wouldKingBeInCheckAfterMove(srcSquare->getColumn(), srcSquare->getRow(), 
-                                    dstSquare->getColumn(), dstSquare->getRow(), playerNumber)) {
-        return false;
-    }
-
-    return true;
-}
-
-bool Chess::canBitMoveFromToPseudo(Bit &bit, BitHolder &src, BitHolder &dst)
-{
-    // Get source and destination positions
-    ChessSquare* srcSquare = dynamic_cast<ChessSquare*>(&src);
-    ChessSquare* dstSquare = dynamic_cast<ChessSquare*>(&dst);
-    
-    if (!srcSquare || !dstSquare) {
-        return false;
-    }
-
-    int srcX = srcSquare->getColumn();
-    int srcY = srcSquare->getRow();
-    int dstX = dstSquare->getColumn();
-    int dstY = dstSquare->getRow();
-    
-    // Get the piece type and color from the game tag
-    int pieceType = bit.gameTag() & 0x7F;  // Lower 7 bits for piece type
-    bool isWhite = (bit.gameTag() & 0x80) == 0;  // Check if it's white's piece
-    int direction = isWhite ? 1 : -1;  // White moves up (increasing y), black moves down (decreasing y)
-    
-    // Check if the destination has a friendly piece
-    if (dst.bit() && dst.bit()->getOwner() == bit.getOwner()) {
-        return false;
-    }
-
-    // Handle movement based on piece type
-    switch (pieceType) {
-        case Pawn: {
-            // Pawns move forward one square, or two squares from starting position
-            int startRank = isWhite ? 1 : 6;
-            int forwardOne = srcY + direction;
-            int forwardTwo = srcY + 2 * direction;
-            
-            // Check for forward move (no capture)
-            if (srcX == dstX && !dst.bit()) {
-                // Move forward one square
-                if (dstY == forwardOne) {
-                    return true;
-                }
-                // Move forward two squares from starting position
-                if (srcY == startRank && dstY == forwardTwo && !_grid->getSquare(dstX, forwardOne)->bit()) {
-                    return true;
-                }
-            }
-            // Check for capture (diagonal)
-            else if (abs(dstX - srcX) == 1 && dstY == forwardOne) {
-                // Can capture if there's an opponent's piece at the destination
-                if (dst.bit() && dst.bit()->getOwner() != bit.getOwner()) {
-                    return true;
-                }
-                // En Passant
-                if (_enPassantColumn != -1 && dstX == _enPassantColumn && dstY == _enPassantTargetRow) {
-                    return true;
-                }
-            }
-            return false;
-        }
-        
-        case Knight: {
-            // Knight moves in L-shape: 2 in one direction, then 1 perpendicular
-            int dx = abs(dstX - srcX);
-            int dy = abs(dstY - srcY);
-            return (dx == 2 && dy == 1) || (dx == 1 && dy == 2);
-        }
-        
-        case King: {
-            // Check for castling
-            int dx = dstX - srcX;
-            int dy = dstY - srcY;
-            
-            // Normal king move (one square in any direction)
-            if (abs(dx) <= 1 && abs(dy) <= 1) {
-                return true;
-            }
-            
-            // Check for castling (2 squares horizontally)
-            if (abs(dx) == 2 && dy == 0) {
-                bool kingside = (dx > 0);
-                int row = isWhite ? 0 : 7;
-                int playerIndex = isWhite ? 0 : 2;
-                
-                // Check if castling is allowed for this side
-                if (!_castlingRights[playerIndex + (kingside ? 0 : 1)]) {
-                    return false;
-                }
-                
-                // Check if squares between king and rook are empty
-                int checkStart = kingside ? srcX + 1 : 1;
-                int checkEnd = kingside ? dstX : srcX;
-                
-                for (int x = checkStart; x < checkEnd; x++) {
-                    ChessSquare* square = _grid->getSquare(x, row);
-                    if (!square || square->bit()) {
-                        return false;  // Path blocked or invalid
-                    }
-                }
-                
-                // NOTE: We don't check isSquareUnderAttack here to avoid infinite recursion
-                // The attack checks are done in generateKingMoves instead
-                return true;
-            }
-            
-            return false;
-        }
-        
-        case Rook: {
-            // Rook moves horizontally or vertically any number of squares
-            if (srcX != dstX && srcY != dstY) {
-                return false; // Must be on the same rank or file
-            }
-            
-            int stepX = (dstX > srcX) ? 1 : (dstX < srcX) ? -1 : 0;
-            int stepY = (dstY > srcY) ? 1 : (dstY < srcY) ? -1 : 0;
-            
-            // Check if the path is clear
-            int x = srcX + stepX;
-            int y = srcY + stepY;
-            while (x != dstX || y != dstY) {
-                if (_grid->getSquare(x, y)->bit()) {
-                    return false; // Path is blocked
-                }
-                x += stepX;
-                y += stepY;
-            }
-            
-            return true;
-        }
-        
-        case Bishop: {
-            // Bishop moves diagonally any number of squares
-            int dx = abs(dstX - srcX);
-            int dy = abs(dstY - srcY);
-            
-            // Must move diagonally (equal x and y distance)
-            if (dx != dy) {
-                return false;
-            }
-            
-            int stepX = (dstX > srcX) ? 1 : -1;
-            int stepY = (dstY > srcY) ? 1 : -1;
-            
-            // Check if the path is clear
-            int x = srcX + stepX;
-            int y = srcY + stepY;
-            while (x != dstX && y != dstY) {  // Only need to check one coordinate since they change at the same rate
-                if (_grid->getSquare(x, y)->bit()) {
-                    return false; // Path is blocked
-                }
-                x += stepX;
-                y += stepY;
-            }
-            
-            return true;
-        }
-        
-        case Queen: {
-            // Queen combines rook and bishop movement
-            int dx = abs(dstX - srcX);
-            int dy = abs(dstY - srcY);
-            
-            // Must move in a straight line (same rank, file, or diagonal)
-            if (dx != 0 && dy != 0 && dx != dy) {
-                return false;
-            }
-            
-            int stepX = (dstX > srcX) ? 1 : (dstX < srcX) ? -1 : 0;
-            int stepY = (dstY > srcY) ? 1 : (dstY < srcY) ? -1 : 0;
-            
-            // Check if the path is clear
-            int x = srcX + stepX;
-            int y = srcY + stepY;
-            while (x != dstX || y != dstY) {
-                if (_grid->getSquare(x, y)->bit()) {
-                    return false; // Path is blocked
-                }
-                x += stepX;
-                y += stepY;
-            }
-            
-            return true;
-        }
-        
-        default:
-            // Other pieces not implemented yet
-            return false;
-    }
+    // Only fully legal moves of the side to move are generated
+    return !moveForSquares(*srcSquare, *dstSquare).isNull();
 }
 
 void Chess::stopGame()
 {
+    cancelThinking();
     _grid->forEachSquare([](ChessSquare* square, int x, int y) {
         square->destroyBit();
     });
+    _position.clear();
 }
 
 Player* Chess::ownerAt(int x, int y) const
@@ -595,33 +281,19 @@ Player* Chess::ownerAt(int x, int y) const
 Player* Chess::checkForWinner()
 {
     // First check if either king has been captured (this should never happen in proper chess)
-    bool whiteKingExists = false;
-    bool blackKingExists = false;
-    
-    _grid->forEachSquare([&](ChessSquare* square, int x, int y) {
-        Bit* piece = square->bit();
-        if (piece && (piece->gameTag() & 0x7F) == King) {
-            bool isWhite = (piece->gameTag() & 0x80) == 0;
-            if (isWhite) {
-                whiteKingExists = true;
-            } else {
-                blackKingExists = true;
-            }
-        }
-    });
-    
     // If a king is missing, the opponent wins
-    if (!whiteKingExists) {
+    if (_position.kingSquare(White) < 0) {
         return getPlayerAt(1); // Black wins
     }
-    if (!blackKingExists) {
+    if (_position.kingSquare(Black) < 0) {
         return getPlayerAt(0); // White wins
     }
     
     int currentPlayerNum = getCurrentPlayer()->playerNumber();
     
     // Check if current player has any legal moves
-    auto moves = generateAllMoves(currentPlayerNum);
+    MoveList moves;
+    _position.generateLegalMoves(moves);
     if (moves.empty()) {
         if (isInCheck(currentPlayerNum)) {
             // Checkmate - Opponent wins
@@ -637,7 +309,8 @@ Player* Chess::checkForWinner()
 bool Chess::checkForDraw()
 {
     int currentPlayerNum = getCurrentPlayer()->playerNumber();
-    auto moves = generateAllMoves(currentPlayerNum);
+    MoveList moves;
+    _position.generateLegalMoves(moves);
     if (moves.empty() && !isInCheck(currentPlayerNum)) {
         return true;
     }
@@ -661,6 +334,7 @@ std::string Chess::stateString()
 
 void Chess::setStateString(const std::string &s)
 {
+    cancelThinking();
     _grid->forEachSquare([&](ChessSquare* square, int x, int y) {
         int index = y * 8 + x;
         char playerNumber = s[index] - '0';
@@ -672,215 +346,6 @@ void Chess::setStateString(const std::string &s)
     });
 }
 
-// Move Generator Implementation
-std::vector<Chess::Move> Chess::generateAllMoves(int playerNumber)
-{
-    std::vector<Move> allMoves;
-    
-    _grid->forEachSquare([&](ChessSquare* square, int x, int y) {
-        Bit* piece = square->bit();
-        if (!piece) return;
-        
-        // Check if this piece belongs to the current player
-        int pieceColor = piece->gameTag() & 128;
-        bool isWhitePiece = (pieceColor == 0);
-        bool isPlayerWhite = (playerNumber == 0);
-        
-        if (isWhitePiece == isPlayerWhite) {
-            int pieceType = piece->gameTag() & 0x7F;
-            
-            switch (pieceType) {
-                case Pawn:
-                    for (auto move : generatePawnMoves(x, y, piece)) {
-                        allMoves.push_back(move);
-                    }
-                    break;
-                case Knight:
-                    for (auto move : generateKnightMoves(x, y, piece)) {
-                        allMoves.push_back(move);
-                    }
-                    break;
-                case King:
-                    for (auto move : generateKingMoves(x, y, piece)) {
-                        allMoves.push_back(move);
-                    }
-                    break;
-                case Rook:
-                    for (auto move : generateRookMoves(x, y, piece)) {
-                        allMoves.push_back(move);
-                    }
-                    break;
-                case Bishop:
-                    for (auto move : generateBishopMoves(x, y, piece)) {
-                        allMoves.push_back(move);
-                    }
-                    break;
-                case Queen:
-                    for (auto move : generateQueenMoves(x, y, piece)) {
-                        allMoves.push_back(move);
-                    }
-                    break;
-                default:
-                    break;
-            }
-        }
-    });
-    
-    // Filter out moves that leave the king in check
-    std::vector<Move> validMoves;
-    for (const auto& move : allMoves) {
-        if (!wouldKingBeInCheckAfterMove(move.fromX, move.fromY, move.toX, move.toY, playerNumber)) {
-            validMoves.push_back(move);
-        }
-    }
-    
-    return validMoves;
-}
-
-std::vector<Chess::Move> Chess::generatePawnMoves(int x, int y, Bit* piece)
-{
-    std::vector<Move> moves;
-    bool isWhite = (piece->gameTag() & 128) == 0;
-    int direction = isWhite ? 1 : -1;
-    int startRank = isWhite ? 1 : 6;
-    
-    // Forward one square
-    int newY = y + direction;
-    if (newY >= 0 && newY < 8) {
-        ChessSquare* targetSquare = _grid->getSquare(x, newY);
-        if (targetSquare && !targetSquare->bit()) {
-            moves.push_back(Move(x, y, x, newY, _grid->getSquare(x, y), targetSquare, piece));
-        }
-    }
-    
-    // Forward two squares from starting position
-    if (y == startRank) {
-        newY = y + 2 * direction;
-        int middleY = y + direction;
-        if (newY >= 0 && newY < 8) {
-            ChessSquare* targetSquare = _grid->getSquare(x, newY);
-            ChessSquare* middleSquare = _grid->getSquare(x, middleY);
-            if (targetSquare && middleSquare && !targetSquare->bit() && !middleSquare->bit()) {
-                moves.push_back(Move(x, y, x, newY, _grid->getSquare(x, y), targetSquare, piece));
-            }
-        }
-    }
-    
-    // Diagonal captures
-    for (int dx = -1; dx <= 1; dx += 2) {
-        int newX = x + dx;
-        newY = y + direction;
-        if (newX >= 0 && newX < 8 && newY >= 0 && newY < 8) {
-            ChessSquare* targetSquare = _grid->getSquare(newX, newY);
-            if (targetSquare && targetSquare->bit() && targetSquare->bit()->getOwner() != piece->getOwner()) {
-                moves.push_back(Move(x, y, newX, newY, _grid->getSquare(x, y), targetSquare, piece));
-            }
-        }
-    }
-    
-    // En Passant
-    if (_enPassantColumn != -1) {
-        if (abs(x - _enPassantColumn) == 1) {
-            int forwardOne = y + direction;
-            if (forwardOne == _enPassantTargetRow) {
-                ChessSquare* targetSquare = _grid->getSquare(_enPassantColumn, _enPassantTargetRow);
-                if (targetSquare && !targetSquare->bit()) {
-                    moves.push_back(Move(x, y, _enPassantColumn, _enPassantTargetRow, _grid->getSquare(x, y), targetSquare, piece));
-                }
-            }
-        }
-    }
-    
-    return moves;
-}
-
-std::vector<Chess::Move> Chess::generateKnightMoves(int x, int y, Bit* piece)
-{
-    std::vector<Move> moves;
-    int knightMoves[8][2] = {{2,1}, {2,-1}, {-2,1}, {-2,-1}, {1,2}, {1,-2}, {-1,2}, {-1,-2}};
-    
-    for (auto& move : knightMoves) {
-        int newX = x + move[0];
-        int newY = y + move[1];
-        
-        if (newX >= 0 && newX < 8 && newY >= 0 && newY < 8) {
-            ChessSquare* targetSquare = _grid->getSquare(newX, newY);
-            if (targetSquare && (!targetSquare->bit() || targetSquare->bit()->getOwner() != piece->getOwner())) {
-                moves.push_back(Move(x, y, newX, newY, _grid->getSquare(x, y), targetSquare, piece));
-            }
-        }
-    }
-    
-    return moves;
-}
-
-std::vector<Chess::Move> Chess::generateKingMoves(int x, int y, Bit* piece)
-{
-    std::vector<Move> moves;
-    
-    // King moves one square in any direction
-    for (int dx = -1; dx <= 1; dx++) {
-        for (int dy = -1; dy <= 1; dy++) {
-            if (dx == 0 && dy == 0) continue;
-            
-            int newX = x + dx;
-            int newY = y + dy;
-            
-            if (newX >= 0 && newX < 8 && newY >= 0 && newY < 8) {
-                ChessSquare* targetSquare = _grid->getSquare(newX, newY);
-                if (targetSquare && (!targetSquare->bit() || targetSquare->bit()->getOwner() != piece->getOwner())) {
-                    moves.push_back(Move(x, y, newX, newY, _grid->getSquare(x, y), targetSquare, piece));
-                }
-            }
-        }
-    }
-    
-    // Check for castling
-    bool isWhite = (piece->gameTag() & 0x80) == 0;
-    int row = isWhite ? 0 : 7;
-    int playerIndex = isWhite ? 0 : 2; // 0=white, 2=black for _castlingRights
-    
-    // Kingside castling
-    if (_castlingRights[playerIndex]) {
-        bool canCastle = true;
-        // Check if squares between king and rook are empty
-        for (int i = x + 1; i < 7; i++) {
-            if (_grid->getSquare(i, row)->bit()) {
-                canCastle = false;
-                break;
-            }
-        }
-        // Check if squares king moves through are not under attack
-        if (canCastle && !isSquareUnderAttack(x, y, !isWhite) && 
-            !isSquareUnderAttack(x + 1, row, !isWhite) && 
-            !isSquareUnderAttack(x + 2, row, !isWhite)) {
-            ChessSquare* targetSquare = _grid->getSquare(x + 2, row);
-            moves.push_back(Move(x, y, x + 2, row, _grid->getSquare(x, y), targetSquare, piece));
-        }
-    }
-    
-    // Queenside castling
-    if (_castlingRights[playerIndex + 1]) {
-        bool canCastle = true;
-        // Check if squares between king and rook are empty
-        for (int i = x - 1; i > 0; i--) {
-            if (_grid->getSquare(i, row)->bit()) {
-                canCastle = false;
-                break;
-            }
-        }
-        // Check if squares king moves through are not under attack
-        if (canCastle && !isSquareUnderAttack(x, y, !isWhite) && 
-            !isSquareUnderAttack(x - 1, row, !isWhite) && 
-            !isSquareUnderAttack(x - 2, row, !isWhite)) {
-            ChessSquare* targetSquare = _grid->getSquare(x - 2, row);
-            moves.push_back(Move(x, y, x - 2, row, _grid->getSquare(x, y), targetSquare, piece));
-        }
-    }
-    
-    return moves;
-}
-
 bool Chess::isValidMove(int playerNumber, int fromX, int fromY, int toX, int toY)
 {
     ChessSquare* fromSquare = _grid->getSquare(fromX, fromY);
@@ -894,168 +359,38 @@ bool Chess::isValidMove(int playerNumber, int fromX, int fromY, int toX, int toY
     return canBitMoveFromTo(*piece, *fromSquare, *toSquare);
 }
 
-// AI Evaluation Function
-int Chess::evaluateBoard(int playerNumber)
-{
-    int score = 0;
-    
-    // Piece values
-    const int PAWN_VALUE = 100;
-    const int KNIGHT_VALUE = 320;
-    const int BISHOP_VALUE = 330;
-    const int ROOK_VALUE = 500;
-    const int QUEEN_VALUE = 900;
-    const int KING_VALUE = 20000;
-    
-    _grid->forEachSquare([&](ChessSquare* square, int x, int y) {
-        Bit* piece = square->bit();
-        if (!piece) return;
-        
-        int pieceType = piece->gameTag() & 0x7F;
-        bool isWhite = (piece->gameTag() & 0x80) == 0;
-        int pieceValue = 0;
-        
-        switch (pieceType) {
-            case Pawn: pieceValue = PAWN_VALUE; break;
-            case Knight: pieceValue = KNIGHT_VALUE; break;
-            case Bishop: pieceValue = BISHOP_VALUE; break;
-            case Rook: pieceValue = ROOK_VALUE; break;
-            case Queen: pieceValue = QUEEN_VALUE; break;
-            case King: pieceValue = KING_VALUE; break;
-            default: pieceValue = 0; break;
-        }
-        
-        // Add to score based on which player owns the piece
-        if ((isWhite && playerNumber == 0) || (!isWhite && playerNumber == 1)) {
-            score += pieceValue;
-        } else {
-            score -= pieceValue;
-        }
-    });
-    
-    return score;
-}
-
-// Helper function to make a move (for search)
-void Chess::makeMove(const Move& move)
+// Find the best move for the side to move in the game position
+ChessMove Chess::findBestMove(int playerNumber)
 {
-    // Use releaseBit to avoid deleting the captured piece
-    if (move.toSquare->bit()) {
-        move.toSquare->releaseBit();
-    }
-    // Release from source and set to destination
-    move.fromSquare->releaseBit();
-    move.toSquare->setBit(move.piece);
+    cancelThinking();
+    return _search.findBestMove(_position, searchLimits());
 }
 
-// Helper function to unmake a move (for search)
-void Chess::unmakeMove(const Move& move, Bit* capturedPiece, int oldEnPassantCol, int oldEnPassantRow, int oldEnPassantTarget)
+SearchLimits Chess::searchLimits() const
 {
-    // Release the piece from destination
-    move.toSquare->releaseBit();
-    // Restore original positions
-    move.fromSquare->setBit(move.piece);
-    move.toSquare->setBit(capturedPiece);
-    
-    _enPassantColumn = oldEnPassantCol;
-    _enPassantRow = oldEnPassantRow;
-    _enPassantTargetRow = oldEnPassantTarget;
+    SearchLimits limits;
+    limits.maxDepth = _gameOptions.AIMAXDepth;
+    limits.maxNodes = static_cast<uint64_t>(_gameOptions.AIDepthSearches) * 1000;
+    limits.moveTimeMs = _gameOptions.AIMoveTimeMs;
+    return limits;
 }
 
-// Negamax with Alpha-Beta Pruning
-int Chess::negamax(int depth, int alpha, int beta, int playerNumber)
+void Chess::updateBackgroundMove()
 {
-    if (depth == 0) {
-        return evaluateBoard(playerNumber);
-    }
-    
-    std::vector<Move> moves = generateAllMoves(playerNumber);
-    
-    // Check for game over
-    if (moves.empty()) {
-        if (isInCheck(playerNumber)) {
-            return -50000; // Checkmate
+    ChessMove move;
+    uint64_t positionKey;
+    if (_async.takeMove(move, positionKey)) {
+        // the search was for this exact position, or it would have been cancelled
+        if (positionKey == _position.key() && _position.isLegal(move)) {
+            _moveCount++;
+            commitMove(move);
+            endTurn();
         }
-        return 0; // Stalemate
+        return;
     }
-    
-    // Move ordering: prioritize captures for better alpha-beta pruning
-    std::sort(moves.begin(), moves.end(), [](const Move& a, const Move& b) {
-        bool aIsCapture = (a.toSquare->bit() != nullptr);
-        bool bIsCapture = (b.toSquare->bit() != nullptr);
-        return aIsCapture > bIsCapture; // Captures first
-    });
-    
-    int maxScore = INT_MIN;
-    
-    for (const auto& move : moves) {
-        // Save state
-        Bit* capturedPiece = move.toSquare->bit();
-        int oldEnPassantCol = _enPassantColumn;
-        int oldEnPassantRow = _enPassantRow;
-        int oldEnPassantTarget = _enPassantTargetRow;
-        
-        // Make move
-        makeMove(move);
-        
-        // Recurse
-        int opponentPlayer = (playerNumber == 0) ? 1 : 0;
-        int score = -negamax(depth - 1, -beta, -alpha, opponentPlayer);
-        
-        // Unmake move
-        unmakeMove(move, capturedPiece, oldEnPassantCol, oldEnPassantRow, oldEnPassantTarget);
-        
-        maxScore = std::max(maxScore, score);
-        alpha = std::max(alpha, score);
-        
-        if (alpha >= beta) {
-            break; // Beta cutoff
-        }
+    if (!_async.thinking()) {
+        _async.start(_position, searchLimits());
     }
-    
-    return maxScore;
-}
-
-// Find the best move using Negamax
-Chess::Move Chess::findBestMove(int playerNumber)
-{
-    std::vector<Move> moves = generateAllMoves(playerNumber);
-    
-    if (moves.empty()) {
-        // Return a dummy move if no moves available
-        return Move(0, 0, 0, 0, nullptr, nullptr, nullptr);
-    }
-    
-    Move bestMove = moves[0];
-    int bestScore = INT_MIN;
-    
-    for (const auto& move : moves) {
-        // Save state
-        Bit* capturedPiece = move.toSquare->bit();
-        int oldEnPassantCol = _enPassantColumn;
-        int oldEnPassantRow = _enPassantRow;
-        int oldEnPassantTarget = _enPassantTargetRow;
-        
-        // Make move
-        makeMove(move);
-        
-        // Evaluate
-        int opponentPlayer = (playerNumber == 0) ? 1 : 0;
-        int score = -negamax(2, INT_MIN, INT_MAX, opponentPlayer); // Depth 2 (total depth 3)
-        
-        // Add small random noise to break ties and prevent repetition
-        score += (rand() % 10) - 5; // Random value between -5 and +4
-        
-        // Unmake move
-        unmakeMove(move, capturedPiece, oldEnPassantCol, oldEnPassantRow, oldEnPassantTarget);
-        
-        if (score > bestScore) {
-            bestScore = score;
-            bestMove = move;
-        }
-    }
-    
-    return bestMove;
 }
 
 void Chess::makeRandomMove(int playerNumber)
@@ -1063,21 +398,11 @@ void Chess::makeRandomMove(int playerNumber)
     _moveCount++;
     
     // Use Negamax to find the best move
-    Move bestMove = findBestMove(playerNumber);
+    ChessMove bestMove = findBestMove(playerNumber);
     
     // Execute the move
-    if (bestMove.fromSquare && bestMove.toSquare && bestMove.piece) {
-        // Remove piece from destination if there's a capture
-        if (bestMove.toSquare->bit()) {
-            bestMove.toSquare->destroyBit();
-        }
-        
-        // Move the piece
-        bestMove.toSquare->setBit(bestMove.piece);
-        bestMove.fromSquare->setBit(nullptr);
-        
-        // Update the visual position of the piece
-        bestMove.piece->setPosition(bestMove.toSquare->getPosition());
+    if (!bestMove.isNull()) {
+        commitMove(bestMove);
         
         // End the turn
         endTurn();
@@ -1087,235 +412,18 @@ void Chess::makeRandomMove(int playerNumber)
 std::vector<std::pair<int,int>> Chess::getAllValidMovesForCurrentPlayer()
 {
     std::vector<std::pair<int,int>> validMoves;
-    int currentPlayer = getCurrentPlayer()->playerNumber();
-    std::vector<Move> allMoves = generateAllMoves(currentPlayer);
+    MoveList moves;
+    _position.generateLegalMoves(moves);
     
-    for (const auto& move : allMoves) {
-        validMoves.push_back({move.toX, move.toY});
+    for (ChessMove move : moves) {
+        validMoves.push_back({fileOf(move.to()), rankOf(move.to())});
     }
     
     return validMoves;
 }
 
-bool Chess::isSquareUnderAttack(int x, int y, bool byWhite) {
-    // Check if any of the opponent's pieces can move to (x,y)
-    for (int i = 0; i < 8; i++) {
-        for (int j = 0; j < 8; j++) {
-            ChessSquare* square = _grid->getSquare(i, j);
-            if (!square || !square->bit()) continue;
-            
-            // Only check pieces of the attacking color
-            bool pieceIsWhite = (square->bit()->gameTag() & 0x80) == 0;
-            if (pieceIsWhite != byWhite) continue;
-            
-            // Skip if it's a king (to avoid infinite recursion)
-            int pieceType = square->bit()->gameTag() & 0x7F;
-            if (pieceType == King) continue;
-            
-            // Check if this piece can attack the target square
-            ChessSquare* targetSquare = _grid->getSquare(x, y);
-            if (targetSquare && canBitMoveFromToPseudo(*square->bit(), *square, *targetSquare)) {
-                return true;
-            }
-        }
-    }
-    return false;
-}
-
-bool Chess::wouldKingBeInCheckAfterMove(int fromX, int fromY, int toX, int toY, int playerNumber) {
-    // Temporarily make the move
-    ChessSquare* fromSquare = _grid->getSquare(fromX, fromY);
-    ChessSquare* toSquare = _grid->getSquare(toX, toY);
-    if (!fromSquare || !toSquare || !fromSquare->bit()) return true;
-    
-    // Save the original state
-    // Use releaseBit() to prevent the pieces from being deleted by setBit()
-    Bit* movingPiece = fromSquare->releaseBit();
-    Bit* capturedPiece = toSquare->releaseBit();
-    
-    // Make the move
-    toSquare->setBit(movingPiece);
-
-    // Handle En Passant simulation
-    Bit* enPassantCapturedPiece = nullptr;
-    ChessSquare* enPassantCapturedSquare = nullptr;
-    
-    if (movingPiece && (movingPiece->gameTag() & 0x7F) == Pawn) {
-        if (_enPassantColumn != -1 && toX == _enPassantColumn && toY == _enPassantTargetRow) {
-             enPassantCapturedSquare = _grid->getSquare(_enPassantColumn, _enPassantRow);
-             if (enPassantCapturedSquare) {
-                 // Use releaseBit to avoid deleting the pawn
-                 enPassantCapturedPiece = enPassantCapturedSquare->releaseBit();
-             }
-        }
-    }
-    
-    // Find the king's position
-    int kingX = -1, kingY = -1;
-    bool kingFound = false;
-    
-    for (int y = 0; y < 8 && !kingFound; y++) {
-        for (int x = 0; x < 8; x++) {
-            ChessSquare* square = _grid->getSquare(x, y);
-            if (square && square->bit()) {
-                int pieceType = square->bit()->gameTag() & 0x7F;
-                bool pieceIsWhite = (square->bit()->gameTag() & 0x80) == 0;
-                if (pieceType == King && pieceIsWhite == (playerNumber == 0)) {
-                    kingX = x;
-                    kingY = y;
-                    kingFound = true;
-                    break;
-                }
-            }
-        }
-    }
-    
-    // Check if the king is in check
-    bool inCheck = false;
-    if (kingFound) {
-        inCheck = isSquareUnderAttack(kingX, kingY, playerNumber != 0);
-    }
-    
-    // Undo the move
-    // Release movingPiece from toSquare before putting it back
-    toSquare->releaseBit();
-    fromSquare->setBit(movingPiece);
-    toSquare->setBit(capturedPiece);
-
-    if (enPassantCapturedSquare && enPassantCapturedPiece) {
-        enPassantCapturedSquare->setBit(enPassantCapturedPiece);
-    }
-    
-    return inCheck;
-}
-
-std::vector<Chess::Move> Chess::generateRookMoves(int x, int y, Bit* piece)
-{
-    std::vector<Move> moves;
-    
-    // Directions: right, left, up, down
-    int directions[4][2] = {{1, 0}, {-1, 0}, {0, 1}, {0, -1}};
-    
-    for (auto& dir : directions) {
-        int dx = dir[0];
-        int dy = dir[1];
-        int newX = x + dx;
-        int newY = y + dy;
-        
-        // Move in the current direction until we hit the edge of the board or a piece
-        while (newX >= 0 && newX < 8 && newY >= 0 && newY < 8) {
-            ChessSquare* targetSquare = _grid->getSquare(newX, newY);
-            if (!targetSquare) break;
-            
-            Bit* targetPiece = targetSquare->bit();
-            
-            // If the square is empty, add the move and continue
-            if (!targetPiece) {
-                moves.push_back(Move(x, y, newX, newY, _grid->getSquare(x, y), targetSquare, piece));
-            } 
-            // If the square has an opponent's piece, add the capture and stop in this direction
-            else if (targetPiece->getOwner() != piece->getOwner()) {
-                moves.push_back(Move(x, y, newX, newY, _grid->getSquare(x, y), targetSquare, piece));
-                break;
-            } 
-            // If it's our own piece, stop in this direction
-            else {
-                break;
-            }
-            
-            newX += dx;
-            newY += dy;
-        }
-    }
-    
-    return moves;
-}
-
-std::vector<Chess::Move> Chess::generateBishopMoves(int x, int y, Bit* piece)
-{
-    std::vector<Move> moves;
-    
-    // Directions: top-right, top-left, bottom-right, bottom-left
-    int directions[4][2] = {{1, 1}, {-1, 1}, {1, -1}, {-1, -1}};
-    
-    for (auto& dir : directions) {
-        int dx = dir[0];
-        int dy = dir[1];
-        int newX = x + dx;
-        int newY = y + dy;
-        
-        // Move in the current diagonal direction until we hit the edge of the board or a piece
-        while (newX >= 0 && newX < 8 && newY >= 0 && newY < 8) {
-            ChessSquare* targetSquare = _grid->getSquare(newX, newY);
-            if (!targetSquare) break;
-            
-            Bit* targetPiece = targetSquare->bit();
-            
-            // If the square is empty, add the move and continue
-            if (!targetPiece) {
-                moves.push_back(Move(x, y, newX, newY, _grid->getSquare(x, y), targetSquare, piece));
-            } 
-            // If the square has an opponent's piece, add the capture and stop in this direction
-            else if (targetPiece->getOwner() != piece->getOwner()) {
-                moves.push_back(Move(x, y, newX, newY, _grid->getSquare(x, y), targetSquare, piece));
-                break;
-            } 
-            // If it's our own piece, stop in this direction
-            else {
-                break;
-            }
-            
-            newX += dx;
-            newY += dy;
-        }
-    }
-    
-    return moves;
-}
-
-std::vector<Chess::Move> Chess::generateQueenMoves(int x, int y, Bit* piece)
-{
-    std::vector<Move> moves;
-    
-    // Queen moves are a combination of rook and bishop moves
-    auto rookMoves = generateRookMoves(x, y, piece);
-    auto bishopMoves = generateBishopMoves(x, y, piece);
-    
-    // Combine both move sets
-    moves.insert(moves.end(), rookMoves.begin(), rookMoves.end());
-    moves.insert(moves.end(), bishopMoves.begin(), bishopMoves.end());
-    
-    return moves;
-}
-
-
 bool Chess::isInCheck(int playerNumber) {
-    // Find the king's position
-    int kingX = -1, kingY = -1;
-    bool kingFound = false;
-    
-    for (int y = 0; y < 8 && !kingFound; y++) {
-        for (int x = 0; x < 8; x++) {
-            ChessSquare* square = _grid->getSquare(x, y);
-            if (square && square->bit()) {
-                int pieceType = square->bit()->gameTag() & 0x7F;
-                bool pieceIsWhite = (square->bit()->gameTag() & 0x80) == 0;
-                if (pieceType == King && pieceIsWhite == (playerNumber == 0)) {
-                    kingX = x;
-                    kingY = y;
-                    kingFound = true;
-                    break;
-                }
-            }
-        }
-    }
-    
-    if (kingFound) {
-        // Check if the king is under attack by the opponent
-        // isSquareUnderAttack(x, y, byWhite) checks if 'byWhite' pieces are attacking
-        // If we are White (player 0), we want to know if Black (byWhite=false) is attacking
-        return isSquareUnderAttack(kingX, kingY, playerNumber != 0);
-    }
-    
-    return false;
+    // Check if the king is under attack by the opponent
+    Bitboard opponentAttacks = _position.attacks(playerNumber == 0 ? 1 : 0);
+    return (opponentAttacks & _position.pieces(playerNumber, King)) != 0;
 }
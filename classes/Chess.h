@@ -2,21 +2,14 @@
 
 #include "Game.h"
 #include "Grid.h"
+#include "ChessPosition.h"
+#include "ChessSearch.h"
+#include "AsyncSearch.h"
+#include <future>
 #include <vector>
 
 constexpr int pieceSize = 80;
 
-enum ChessPiece
-{
-    NoPiece,
-    Pawn,
-    Knight,
-    Bishop,
-    Rook,
-    Queen,
-    King
-};
-
 class Chess : public Game
 {
 public:
@@ -42,10 +35,21 @@ public:
     
     // Public move generator interface
     void makeRandomMoveForCurrentPlayer() { makeRandomMove(getCurrentPlayer()->playerNumber()); }
+    // Background AI for the render loop: call once per frame while the AI is to move.
+    // Starts a search on a worker thread if none is running and plays its move once done.
+    void updateBackgroundMove();
+    // abandons the background search; any position change does this automatically
+    void cancelThinking() { _async.cancel(); }
+    bool isThinking() const { return _async.thinking(); }
     std::vector<std::pair<int,int>> getAllValidMovesForCurrentPlayer();
 
     // Move counter for debugging
     int getMoveCount() const { return _moveCount; }
+
+    // Bitboard position the move generator and search run on
+    const ChessPosition& position() const { return _position; }
+    // 64-bit Zobrist key of the current position, includes side to move, castling and en passant
+    uint64_t positionKey() const { return _position.key(); }
     
     // Board rebuild methods
     void rebuildBoardFromFEN();
@@ -58,60 +62,30 @@ private:
     char pieceNotation(int x, int y) const;
     std::string generateFENFromBoard();
     
-    // Move generator methods
-    struct Move {
-        int fromX, fromY, toX, toY;
-        ChessSquare* fromSquare;
-        ChessSquare* toSquare;
-        Bit* piece;
-        
-        Move(int fx, int fy, int tx, int ty, ChessSquare* fs, ChessSquare* ts, Bit* p)
-            : fromX(fx), fromY(fy), toX(tx), toY(ty), fromSquare(fs), toSquare(ts), piece(p) {}
-    };
-    
-    std::vector<Move> generateAllMoves(int playerNumber);
-    std::vector<Move> generatePawnMoves(int x, int y, Bit* piece);
-    std::vector<Move> generateKnightMoves(int x, int y, Bit* piece);
-    std::vector<Move> generateRookMoves(int x, int y, Bit* piece);
-    std::vector<Move> generateBishopMoves(int x, int y, Bit* piece);
-    std::vector<Move> generateQueenMoves(int x, int y, Bit* piece);
-    std::vector<Move> generateKingMoves(int x, int y, Bit* piece);
+    // Grid <-> position sync
+    void syncGridWithPosition();
+    void commitMove(ChessMove move);
+
+    // ChessMove <-> UI square pair conversion
+    // the legal move between two squares for the side to move, null if there is none
+    ChessMove moveForSquares(ChessSquare& src, ChessSquare& dst) const;
+    std::pair<ChessSquare*, ChessSquare*> squaresForMove(ChessMove move);
+
     bool isValidMove(int playerNumber, int fromX, int fromY, int toX, int toY);
     void makeRandomMove(int playerNumber);
     
     // AI methods
-    int evaluateBoard(int playerNumber);
-    int negamax(int depth, int alpha, int beta, int playerNumber);
-    Move findBestMove(int playerNumber);
-    void makeMove(const Move& move);
-    void unmakeMove(const Move& move, Bit* capturedPiece, int oldEnPassantCol, int oldEnPassantRow, int oldEnPassantTarget);
+    ChessMove findBestMove(int playerNumber);
+    SearchLimits searchLimits() const;
 
     Grid* _grid;
+    ChessPosition _position;
+    ChessSearch _search;
+    AsyncSearch _async{_search};    // after _search, so it is destroyed (and joined) first
+    std::future<void> _bitbases;    // endgame tables being built in the background
     
     // Move counter for debugging
     int _moveCount = 0;
-    
-    // Castling rights: whiteKingside, whiteQueenside, blackKingside, blackQueenside
-    bool _castlingRights[4] = {true, true, true, true};
-    
-    // Track if kings have moved
-    bool _whiteKingMoved = false;
-    bool _blackKingMoved = false;
-    
-    // Track if rooks have moved (indexed by their starting positions)
-    bool _whiteKingsideRookMoved = false;
-    bool _whiteQueensideRookMoved = false;
-    bool _blackKingsideRookMoved = false;
-    bool _blackQueensideRookMoved = false;
-    
-    // En passant tracking
-    int _enPassantColumn = -1;      // Column where en passant is available (-1 if none)
-    int _enPassantRow = -1;         // Row where the vulnerable pawn is located
-    int _enPassantTargetRow = -1;   // Row where the capturing pawn would land
-    
-    // Helper methods for castling
-    bool isSquareUnderAttack(int x, int y, bool byWhite);
-    bool wouldKingBeInCheckAfterMove(int fromX, int fromY, int toX, int toY, int playerNumber);
-    bool canBitMoveFromToPseudo(Bit &bit, BitHolder &src, BitHolder &dst);
+
     bool isInCheck(int playerNumber);
 };
\ No newline at end of file
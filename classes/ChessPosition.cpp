@@ -0,0 +1,729 @@
+#include "ChessPosition.h"
+#include "Attacks.h"
+#include "Evaluation.h"
+#include "Zobrist.h"
+#include <cctype>
+#include <cstdlib>
+#include <cstring>
+#include <algorithm>
+#include <sstream>
+#include <vector>
+
+namespace
+{
+    const char *PieceChars = " PNBRQK  pnbrqk";
+
+    // castling rights that survive a move touching each square
+    int castlingMaskFor(int square)
+    {
+        switch (square) {
+            case 0:  return ~WhiteQueenside;                    // a1
+            case 4:  return ~(WhiteKingside | WhiteQueenside);  // e1
+            case 7:  return ~WhiteKingside;                     // h1
+            case 56: return ~BlackQueenside;                    // a8
+            case 60: return ~(BlackKingside | BlackQueenside);  // e8
+            case 63: return ~BlackKingside;                     // h8
+            default: return ~0;
+        }
+    }
+}
+
+std::string moveToString(ChessMove move)
+{
+    std::string text;
+    text += static_cast<char>('a' + fileOf(move.from()));
+    text += static_cast<char>('1' + rankOf(move.from()));
+    text += static_cast<char>('a' + fileOf(move.to()));
+    text += static_cast<char>('1' + rankOf(move.to()));
+    if (move.isPromotion()) {
+        text += " pnbrqk"[move.promotionPiece()];
+    }
+    return text;
+}
+
+ChessPosition::ChessPosition()
+{
+    clear();
+}
+
+void ChessPosition::clear()
+{
+    for (int color = 0; color < 2; color++) {
+        for (int piece = 0; piece < 6; piece++) {
+            _pieces[color][piece] = 0;
+        }
+        _occupancy[color] = 0;
+    }
+    _occupied = 0;
+    for (int square = 0; square < 64; square++) {
+        _board[square] = 0;
+    }
+    _kingSquare[White] = -1;
+    _kingSquare[Black] = -1;
+    invalidateAttacks();
+    _sideToMove = White;
+    _castlingRights = 0;
+    _enPassantSquare = -1;
+    _halfmoveClock = 0;
+    _fullmoveNumber = 1;
+    _historySize = 0;
+    _key = 0;
+    _pawnKey = 0;
+    _mgScore = 0;
+    _egScore = 0;
+    _phase = 0;
+}
+
+bool ChessPosition::setFromFEN(const std::string &fen)
+{
+    Attacks::init();
+    Zobrist::init();
+    Eval::init();
+    clear();
+
+    std::istringstream stream(fen);
+    std::vector<std::string> fields;
+    std::string field;
+    while (stream >> field) {
+        fields.push_back(field);
+    }
+    if (fields.empty()) {
+        return false;
+    }
+
+    int y = 7; // FEN starts at rank 8 (top) -> internal y = 7
+    int x = 0;
+    for (char c : fields[0]) {
+        if (c == '/') {
+            y -= 1;
+            x = 0;
+            continue;
+        }
+        if (std::isdigit(static_cast<unsigned char>(c))) {
+            x += (c - '0');
+            continue;
+        }
+        const char *found = std::strchr(PieceChars, c);
+        if (!found || c == ' ' || x < 0 || x >= 8 || y < 0 || y >= 8) {
+            return false;
+        }
+        putPiece(squareOf(x, y), static_cast<int>(found - PieceChars));
+        x += 1;
+    }
+    // move generation relies on one king a side and no pawn on a back rank
+    if (popCount(pieces(White, King)) != 1 || popCount(pieces(Black, King)) != 1 ||
+        ((pieces(White, Pawn) | pieces(Black, Pawn)) & (Rank1BB | Rank8BB))) {
+        return false;
+    }
+
+    _sideToMove = (fields.size() > 1 && fields[1] == "b") ? Black : White;
+
+    // board-only FENs get whatever castling the piece placement still allows
+    std::string castling = fields.size() > 2 ? fields[2] : "KQkq";
+    for (char c : castling) {
+        switch (c) {
+            case 'K': _castlingRights |= WhiteKingside; break;
+            case 'Q': _castlingRights |= WhiteQueenside; break;
+            case 'k': _castlingRights |= BlackKingside; break;
+            case 'q': _castlingRights |= BlackQueenside; break;
+            default: break;
+        }
+    }
+    if (_board[4] != makePieceCode(White, King)) _castlingRights &= ~(WhiteKingside | WhiteQueenside);
+    if (_board[7] != makePieceCode(White, Rook)) _castlingRights &= ~WhiteKingside;
+    if (_board[0] != makePieceCode(White, Rook)) _castlingRights &= ~WhiteQueenside;
+    if (_board[60] != makePieceCode(Black, King)) _castlingRights &= ~(BlackKingside | BlackQueenside);
+    if (_board[63] != makePieceCode(Black, Rook)) _castlingRights &= ~BlackKingside;
+    if (_board[56] != makePieceCode(Black, Rook)) _castlingRights &= ~BlackQueenside;
+
+    if (fields.size() > 3 && fields[3].size() == 2) {
+        int file = fields[3][0] - 'a';
+        int rank = fields[3][1] - '1';
+        // the square the pawn that just moved skipped: rank 6 if it was black's, rank 3 if white's.
+        // Kept only if a double push really could have left it: the pawn in front of it, and
+        // both it and the pawn's starting square empty
+        if (file >= 0 && file < 8 && rank == (_sideToMove == White ? 5 : 2)) {
+            int square = squareOf(file, rank);
+            int forward = _sideToMove == White ? -8 : 8;
+            if (_board[square + forward] == makePieceCode(_sideToMove ^ 1, Pawn) &&
+                !_board[square] && !_board[square - forward]) {
+                _enPassantSquare = square;
+            }
+        }
+    }
+    if (fields.size() > 4) {
+        _halfmoveClock = std::atoi(fields[4].c_str());
+    }
+    if (fields.size() > 5) {
+        _fullmoveNumber = std::max(1, std::atoi(fields[5].c_str()));
+    }
+    _key = computeKey();
+    return true;
+}
+
+std::string ChessPosition::toFEN() const
+{
+    std::string fen;
+    for (int y = 7; y >= 0; y--) {
+        int emptyCount = 0;
+        for (int x = 0; x < 8; x++) {
+            int code = _board[squareOf(x, y)];
+            if (!code) {
+                emptyCount++;
+                continue;
+            }
+            if (emptyCount > 0) {
+                fen += std::to_string(emptyCount);
+                emptyCount = 0;
+            }
+            fen += PieceChars[code];
+        }
+        if (emptyCount > 0) {
+            fen += std::to_string(emptyCount);
+        }
+        if (y > 0) {
+            fen += "/";
+        }
+    }
+
+    fen += _sideToMove == White ? " w " : " b ";
+    if (_castlingRights & WhiteKingside) fen += 'K';
+    if (_castlingRights & WhiteQueenside) fen += 'Q';
+    if (_castlingRights & BlackKingside) fen += 'k';
+    if (_castlingRights & BlackQueenside) fen += 'q';
+    if (!_castlingRights) fen += '-';
+
+    if (_enPassantSquare >= 0) {
+        fen += ' ';
+        fen += static_cast<char>('a' + fileOf(_enPassantSquare));
+        fen += static_cast<char>('1' + rankOf(_enPassantSquare));
+    } else {
+        fen += " -";
+    }
+    fen += ' ';
+    fen += std::to_string(_halfmoveClock);
+    fen += ' ';
+    fen += std::to_string(_fullmoveNumber);
+    return fen;
+}
+
+Bitboard ChessPosition::attacks(int color) const
+{
+    if (!(_attacksValid & (1 << color))) {
+        _attacks[color] = computeAttacks(color);
+        _attacksValid |= 1 << color;
+    }
+    return _attacks[color];
+}
+
+Bitboard ChessPosition::computeAttacks(int color) const
+{
+    Bitboard occupied = _occupied & ~pieces(color ^ 1, King);
+
+    // pawns are done set-wise, a shift per capture direction
+    Bitboard pawns = pieces(color, Pawn);
+    Bitboard result = color == White ? ((pawns & ~FileABB) << 7) | ((pawns & ~FileHBB) << 9)
+                                     : ((pawns & ~FileABB) >> 9) | ((pawns & ~FileHBB) >> 7);
+
+    Bitboard knights = pieces(color, Knight);
+    while (knights) {
+        result |= Attacks::knight(popLsb(knights));
+    }
+    Bitboard diagonal = pieces(color, Bishop) | pieces(color, Queen);
+    while (diagonal) {
+        result |= Attacks::bishop(popLsb(diagonal), occupied);
+    }
+    Bitboard straight = pieces(color, Rook) | pieces(color, Queen);
+    while (straight) {
+        result |= Attacks::rook(popLsb(straight), occupied);
+    }
+    if (_kingSquare[color] >= 0) {
+        result |= Attacks::king(_kingSquare[color]);
+    }
+    return result;
+}
+
+uint64_t ChessPosition::enPassantKey() const
+{
+    // only hashed when a pawn could actually take, so positions reached with and
+    // without a harmless double push share a key
+    if (_enPassantSquare < 0 || !(Attacks::pawn(_sideToMove ^ 1, _enPassantSquare) & pieces(_sideToMove, Pawn))) {
+        return 0;
+    }
+    return Zobrist::EnPassantFile[fileOf(_enPassantSquare)];
+}
+
+uint64_t ChessPosition::computeKey() const
+{
+    uint64_t key = 0;
+    for (int square = 0; square < 64; square++) {
+        if (_board[square]) {
+            key ^= Zobrist::piece(_board[square], square);
+        }
+    }
+    key ^= Zobrist::Castling[_castlingRights] ^ enPassantKey();
+    if (_sideToMove == Black) {
+        key ^= Zobrist::SideToMove;
+    }
+    return key;
+}
+
+bool ChessPosition::inCheck() const
+{
+    return (attacks(_sideToMove ^ 1) & pieces(_sideToMove, King)) != 0;
+}
+
+void ChessPosition::putPiece(int square, int code)
+{
+    int color = pieceColorOf(code);
+    Bitboard b = squareBB(square);
+    _pieces[color][pieceTypeOf(code) - 1] |= b;
+    _occupancy[color] |= b;
+    _occupied |= b;
+    _board[square] = static_cast<uint8_t>(code);
+    _key ^= Zobrist::piece(code, square);
+    _mgScore += Eval::PieceSquareMg[code][square];
+    _egScore += Eval::PieceSquareEg[code][square];
+    _phase += Eval::PhaseWeight[pieceTypeOf(code)];
+    if (pieceTypeOf(code) == Pawn) {
+        _pawnKey ^= Zobrist::piece(code, square);
+    } else if (pieceTypeOf(code) == King) {
+        _kingSquare[color] = square;
+    }
+}
+
+void ChessPosition::removePiece(int square)
+{
+    int code = _board[square];
+    int color = pieceColorOf(code);
+    Bitboard b = squareBB(square);
+    _pieces[color][pieceTypeOf(code) - 1] &= ~b;
+    _occupancy[color] &= ~b;
+    _occupied &= ~b;
+    _board[square] = 0;
+    _key ^= Zobrist::piece(code, square);
+    _mgScore -= Eval::PieceSquareMg[code][square];
+    _egScore -= Eval::PieceSquareEg[code][square];
+    _phase -= Eval::PhaseWeight[pieceTypeOf(code)];
+    if (pieceTypeOf(code) == Pawn) {
+        _pawnKey ^= Zobrist::piece(code, square);
+    } else if (pieceTypeOf(code) == King) {
+        _kingSquare[color] = -1;
+    }
+}
+
+void ChessPosition::movePiece(int from, int to)
+{
+    int code = _board[from];
+    removePiece(from);
+    putPiece(to, code);
+}
+
+void ChessPosition::makeMove(ChessMove move)
+{
+    int us = _sideToMove;
+    int from = move.from();
+    int to = move.to();
+    int moving = pieceTypeOf(_board[from]);
+    int capturedSquare = move.isEnPassant() ? to + (us == White ? -8 : 8) : to;
+
+    if (_historySize == MaxHistory) {
+        // only committed game moves are this old; drop the oldest half so play can continue
+        std::copy(_history + MaxHistory / 2, _history + MaxHistory, _history);
+        _historySize = MaxHistory / 2;
+    }
+    UndoInfo &undo = _history[_historySize++];
+    undo.move = move;
+    undo.captured = _board[capturedSquare];
+    undo.castlingRights = static_cast<uint8_t>(_castlingRights);
+    undo.enPassantSquare = static_cast<int8_t>(_enPassantSquare);
+    undo.halfmoveClock = static_cast<uint16_t>(_halfmoveClock);
+    undo.key = _key;
+
+    // pieces update the key as they move; the state keys are swapped out around them
+    _key ^= Zobrist::Castling[_castlingRights] ^ enPassantKey();
+
+    _halfmoveClock++;
+    if (undo.captured) {
+        removePiece(capturedSquare);
+        _halfmoveClock = 0;
+    }
+
+    movePiece(from, to);
+
+    if (move.isPromotion()) {
+        removePiece(to);
+        putPiece(to, makePieceCode(us, move.promotionPiece()));
+    }
+
+    if (move.isCastle()) {
+        bool kingside = move.flags() == MoveKingCastle;
+        int rookFrom = kingside ? to + 1 : to - 2;
+        int rookTo = kingside ? to - 1 : to + 1;
+        movePiece(rookFrom, rookTo);
+    }
+
+    _enPassantSquare = -1;
+    if (moving == Pawn) {
+        _halfmoveClock = 0;
+        if (move.isDoublePush()) {
+            _enPassantSquare = (from + to) / 2;
+        }
+    }
+
+    _castlingRights &= castlingMaskFor(from) & castlingMaskFor(to);
+    if (us == Black) {
+        _fullmoveNumber++;
+    }
+    _sideToMove = us ^ 1;
+    _key ^= Zobrist::Castling[_castlingRights] ^ enPassantKey() ^ Zobrist::SideToMove;
+    invalidateAttacks();
+}
+
+void ChessPosition::unmakeMove()
+{
+    const UndoInfo &undo = _history[--_historySize];
+    ChessMove move = undo.move;
+    int us = _sideToMove ^ 1;
+    int from = move.from();
+    int to = move.to();
+
+    if (move.isCastle()) {
+        bool kingside = move.flags() == MoveKingCastle;
+        int rookFrom = kingside ? to + 1 : to - 2;
+        int rookTo = kingside ? to - 1 : to + 1;
+        movePiece(rookTo, rookFrom);
+    }
+    if (move.isPromotion()) {
+        removePiece(to);
+        putPiece(to, makePieceCode(us, Pawn));
+    }
+    movePiece(to, from);
+    if (undo.captured) {
+        putPiece(move.isEnPassant() ? to + (us == White ? -8 : 8) : to, undo.captured);
+    }
+
+    _castlingRights = undo.castlingRights;
+    _enPassantSquare = undo.enPassantSquare;
+    _halfmoveClock = undo.halfmoveClock;
+    _key = undo.key;
+    if (us == Black) {
+        _fullmoveNumber--;
+    }
+    _sideToMove = us;
+    invalidateAttacks();
+}
+
+void ChessPosition::makeNullMove()
+{
+    if (_historySize == MaxHistory) {
+        std::copy(_history + MaxHistory / 2, _history + MaxHistory, _history);
+        _historySize = MaxHistory / 2;
+    }
+    UndoInfo &undo = _history[_historySize++];
+    undo.move = ChessMove();
+    undo.captured = 0;
+    undo.castlingRights = static_cast<uint8_t>(_castlingRights);
+    undo.enPassantSquare = static_cast<int8_t>(_enPassantSquare);
+    undo.halfmoveClock = static_cast<uint16_t>(_halfmoveClock);
+    undo.key = _key;
+
+    // no pieces move, so the attack maps stay valid
+    _key ^= enPassantKey() ^ Zobrist::SideToMove;
+    _enPassantSquare = -1;
+    _halfmoveClock++;
+    _sideToMove ^= 1;
+}
+
+void ChessPosition::unmakeNullMove()
+{
+    const UndoInfo &undo = _history[--_historySize];
+    _enPassantSquare = undo.enPassantSquare;
+    _halfmoveClock = undo.halfmoveClock;
+    _key = undo.key;
+    _sideToMove ^= 1;
+}
+
+void ChessPosition::generateLegalMoves(MoveList &moves, MoveGenType type) const
+{
+    generateMoves(moves, type, _occupancy[_sideToMove]);
+}
+
+bool ChessPosition::isLegal(ChessMove move) const
+{
+    // a move from another position (hash move, killer) is checked by generating
+    // only the moving piece's legal moves
+    int code = _board[move.from()];
+    if (move.isNull() || !code || pieceColorOf(code) != _sideToMove) {
+        return false;
+    }
+    MoveList moves;
+    generateMoves(moves, GenAll, squareBB(move.from()));
+    for (ChessMove legal : moves) {
+        if (legal == move) {
+            return true;
+        }
+    }
+    return false;
+}
+
+void ChessPosition::generateMoves(MoveList &moves, MoveGenType type, Bitboard fromSquares) const
+{
+    int us = _sideToMove;
+    int king = kingSquare(us);
+    if (king < 0) {
+        return;
+    }
+
+    // destinations allowed by the generation type; pawns apply it themselves
+    // since their pushes and captures go to different squares
+    Bitboard targets = type == GenCaptures ? _occupancy[us ^ 1] : type == GenQuiets ? ~_occupied : ~0ULL;
+
+    // checkers and pins are worked out once, so every move emitted below is already legal
+    Bitboard checkers = inCheck() ? attackersTo(king, _occupied) & _occupancy[us ^ 1] : 0;
+    if (fromSquares & squareBB(king)) {
+        generateKingMoves(king, checkers, targets, moves);
+    }
+
+    // in double check only the king can move
+    if (checkers & (checkers - 1)) {
+        return;
+    }
+
+    // when in check the other pieces must capture the checker or block it
+    Bitboard checkMask = checkers ? (checkers | Attacks::between(king, lsb(checkers))) : ~0ULL;
+    Bitboard pinned = pinnedPieces(us);
+
+    Bitboard own = _occupancy[us] & fromSquares & ~squareBB(king);
+    while (own) {
+        int square = popLsb(own);
+        // a pinned piece may only move along the line through its king and the pinner
+        Bitboard mask = checkMask;
+        if (pinned & squareBB(square)) {
+            mask &= Attacks::line(king, square);
+        }
+
+        switch (pieceTypeOf(_board[square])) {
+            case Pawn: generatePawnMoves(square, mask, type, moves); break;
+            case Knight: generateKnightMoves(square, mask & targets, moves); break;
+            case Bishop: generateBishopMoves(square, mask & targets, moves); break;
+            case Rook: generateRookMoves(square, mask & targets, moves); break;
+            case Queen: generateQueenMoves(square, mask & targets, moves); break;
+            default: break;
+        }
+    }
+}
+
+Bitboard ChessPosition::attackersTo(int square, Bitboard occupied) const
+{
+    return (Attacks::pawn(Black, square) & pieces(White, Pawn)) |
+           (Attacks::pawn(White, square) & pieces(Black, Pawn)) |
+           (Attacks::knight(square) & (pieces(White, Knight) | pieces(Black, Knight))) |
+           (Attacks::king(square) & (pieces(White, King) | pieces(Black, King))) |
+           (Attacks::bishop(square, occupied) & (pieces(White, Bishop) | pieces(Black, Bishop) | pieces(White, Queen) | pieces(Black, Queen))) |
+           (Attacks::rook(square, occupied) & (pieces(White, Rook) | pieces(Black, Rook) | pieces(White, Queen) | pieces(Black, Queen)));
+}
+
+int ChessPosition::staticExchange(ChessMove move) const
+{
+    int from = move.from();
+    int to = move.to();
+    int us = _sideToMove;
+
+    // gain[d] is the balance after the d-th capture, from the point of view of the side making it
+    int gain[32];
+    int depth = 0;
+    gain[0] = PieceValues[pieceTypeOf(capturedPiece(move))];
+    int onSquare = PieceValues[pieceTypeOf(_board[from])];   // value of the piece that would be taken next
+    if (move.isPromotion()) {
+        gain[0] += PieceValues[move.promotionPiece()] - PieceValues[Pawn];
+        onSquare = PieceValues[move.promotionPiece()];
+    }
+
+    Bitboard occupied = _occupied ^ squareBB(from);
+    if (move.isEnPassant()) {
+        occupied ^= squareBB(to + (us == White ? -8 : 8));
+    }
+    Bitboard diagonal = pieces(White, Bishop) | pieces(Black, Bishop) | pieces(White, Queen) | pieces(Black, Queen);
+    Bitboard straight = pieces(White, Rook) | pieces(Black, Rook) | pieces(White, Queen) | pieces(Black, Queen);
+    Bitboard attackers = attackersTo(to, occupied) & occupied;
+
+    int side = us ^ 1;
+    while (depth < 31) {
+        Bitboard ours = attackers & _occupancy[side];
+        if (!ours) {
+            break;
+        }
+
+        // least valuable attacker
+        int piece = Pawn;
+        while (!(ours & pieces(side, piece))) {
+            piece++;
+        }
+        // the king can only take last
+        if (piece == King && (attackers & _occupancy[side ^ 1])) {
+            break;
+        }
+
+        depth++;
+        gain[depth] = onSquare - gain[depth - 1];
+        onSquare = PieceValues[piece];
+
+        // removing the attacker may uncover a slider behind it
+        occupied ^= squareBB(lsb(ours & pieces(side, piece)));
+        if (piece == Pawn || piece == Bishop || piece == Queen) {
+            attackers |= Attacks::bishop(to, occupied) & diagonal;
+        }
+        if (piece == Rook || piece == Queen) {
+            attackers |= Attacks::rook(to, occupied) & straight;
+        }
+        attackers &= occupied;
+        side ^= 1;
+    }
+
+    // each side only continues the exchange while it pays
+    while (depth > 0) {
+        gain[depth - 1] = -std::max(-gain[depth - 1], gain[depth]);
+        depth--;
+    }
+    return gain[0];
+}
+
+Bitboard ChessPosition::pinnedPieces(int color) const
+{
+    int king = kingSquare(color);
+    int them = color ^ 1;
+    Bitboard queens = pieces(them, Queen);
+    Bitboard snipers = (Attacks::rook(king, 0) & (pieces(them, Rook) | queens)) |
+                       (Attacks::bishop(king, 0) & (pieces(them, Bishop) | queens));
+
+    Bitboard pinned = 0;
+    while (snipers) {
+        Bitboard blockers = Attacks::between(king, popLsb(snipers)) & _occupied;
+        if (blockers && !(blockers & (blockers - 1))) {
+            pinned |= blockers & _occupancy[color];
+        }
+    }
+    return pinned;
+}
+
+void ChessPosition::addMoves(int from, Bitboard targets, MoveList &moves) const
+{
+    targets &= ~_occupancy[_sideToMove];
+    while (targets) {
+        int to = popLsb(targets);
+        moves.push_back(ChessMove(from, to, _board[to] ? MoveCapture : MoveQuiet));
+    }
+}
+
+void ChessPosition::generatePawnMoves(int square, Bitboard mask, MoveGenType type, MoveList &moves) const
+{
+    int us = _sideToMove;
+    int forward = us == White ? 8 : -8;
+    int startRank = us == White ? 1 : 6;
+    int promotionRank = us == White ? 7 : 0;
+
+    // promotions count as captures for staged generation, whether or not they take a piece
+    bool wantQuiets = type != GenCaptures;
+    bool wantCaptures = type != GenQuiets;
+
+    auto addPawnMove = [&](int to, int flags) {
+        if (rankOf(to) == promotionRank) {
+            int promotionFlags = MovePromotion | (flags & MoveCapture);
+            for (int piece : {Queen, Rook, Bishop, Knight}) {
+                moves.push_back(ChessMove(square, to, promotionFlags | (piece - Knight)));
+            }
+        } else {
+            moves.push_back(ChessMove(square, to, flags));
+        }
+    };
+
+    // Forward one square, and two from the starting rank
+    int oneStep = square + forward;
+    if (!(_occupied & squareBB(oneStep))) {
+        bool promotion = rankOf(oneStep) == promotionRank;
+        if ((mask & squareBB(oneStep)) && (promotion ? wantCaptures : wantQuiets)) {
+            addPawnMove(oneStep, MoveQuiet);
+        }
+        int twoStep = oneStep + forward;
+        if (wantQuiets && rankOf(square) == startRank && !(_occupied & squareBB(twoStep)) && (mask & squareBB(twoStep))) {
+            addPawnMove(twoStep, MoveDoublePush);
+        }
+    }
+
+    if (!wantCaptures) {
+        return;
+    }
+
+    // Diagonal captures, with or without promotion
+    Bitboard captures = Attacks::pawn(us, square) & _occupancy[us ^ 1] & mask;
+    while (captures) {
+        addPawnMove(popLsb(captures), MoveCapture);
+    }
+
+    // En Passant: two pawns leave the capturing rank at once, which can expose the king
+    // along it, so test the resulting occupancy directly instead of trusting the masks
+    if (_enPassantSquare >= 0 && (Attacks::pawn(us, square) & squareBB(_enPassantSquare))) {
+        int them = us ^ 1;
+        int king = kingSquare(us);
+        int captured = _enPassantSquare - forward;
+        Bitboard occupied = (_occupied ^ squareBB(square) ^ squareBB(captured)) | squareBB(_enPassantSquare);
+        Bitboard queens = pieces(them, Queen);
+        Bitboard attackers = (Attacks::rook(king, occupied) & (pieces(them, Rook) | queens)) |
+                             (Attacks::bishop(king, occupied) & (pieces(them, Bishop) | queens)) |
+                             (Attacks::knight(king) & pieces(them, Knight)) |
+                             (Attacks::pawn(us, king) & pieces(them, Pawn) & ~squareBB(captured));
+        if (!attackers) {
+            addPawnMove(_enPassantSquare, MoveEnPassant);
+        }
+    }
+}
+
+void ChessPosition::generateKnightMoves(int square, Bitboard mask, MoveList &moves) const
+{
+    addMoves(square, Attacks::knight(square) & mask, moves);
+}
+
+void ChessPosition::generateBishopMoves(int square, Bitboard mask, MoveList &moves) const
+{
+    addMoves(square, Attacks::bishop(square, _occupied) & mask, moves);
+}
+
+void ChessPosition::generateRookMoves(int square, Bitboard mask, MoveList &moves) const
+{
+    addMoves(square, Attacks::rook(square, _occupied) & mask, moves);
+}
+
+void ChessPosition::generateQueenMoves(int square, Bitboard mask, MoveList &moves) const
+{
+    addMoves(square, Attacks::queen(square, _occupied) & mask, moves);
+}
+
+void ChessPosition::generateKingMoves(int square, Bitboard checkers, Bitboard targets, MoveList &moves) const
+{
+    int us = _sideToMove;
+    Bitboard danger = attacks(us ^ 1);
+
+    Bitboard steps = Attacks::king(square) & targets & ~_occupancy[us] & ~danger;
+    while (steps) {
+        int to = popLsb(steps);
+        moves.push_back(ChessMove(square, to, _board[to] ? MoveCapture : MoveQuiet));
+    }
+
+    // Castling: rights still held, not in check, squares between king and rook empty,
+    // and the king does not pass through or land on an attacked square
+    int kingsideRight = us == White ? WhiteKingside : BlackKingside;
+    int queensideRight = us == White ? WhiteQueenside : BlackQueenside;
+    if (checkers || !(targets & ~_occupied) || !(_castlingRights & (kingsideRight | queensideRight))) {
+        return;
+    }
+
+    Bitboard kingsidePath = squareBB(square + 1) | squareBB(square + 2);
+    Bitboard queensidePath = squareBB(square - 1) | squareBB(square - 2);
+    if ((_castlingRights & kingsideRight) && !(_occupied & kingsidePath) && !(danger & kingsidePath)) {
+        moves.push_back(ChessMove(square, square + 2, MoveKingCastle));
+    }
+    if ((_castlingRights & queensideRight) && !(_occupied & (queensidePath | squareBB(square - 3))) && !(danger & queensidePath)) {
+        moves.push_back(ChessMove(square, square - 2, MoveQueenCastle));
+    }
+}
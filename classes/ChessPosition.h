@@ -0,0 +1,263 @@
+#pragma once
+
+#include "Bitboard.h"
+#include <string>
+
+enum ChessPiece
+{
+    NoPiece,
+    Pawn,
+    Knight,
+    Bishop,
+    Rook,
+    Queen,
+    King
+};
+
+// player 0 is white and player 1 is black, same as Game's player numbers
+enum PieceColor
+{
+    White = 0,
+    Black = 1
+};
+
+enum CastlingRight
+{
+    WhiteKingside = 1,
+    WhiteQueenside = 2,
+    BlackKingside = 4,
+    BlackQueenside = 8
+};
+
+// 4-bit move kind stored in the top of a ChessMove
+enum MoveFlag
+{
+    MoveQuiet = 0,
+    MoveDoublePush = 1,
+    MoveKingCastle = 2,
+    MoveQueenCastle = 3,
+    MoveCapture = 4,            // set for every capture, including en passant and promotion captures
+    MoveEnPassant = 5,
+    MovePromotion = 8,          // low two bits hold the promoted piece - Knight
+    MovePromotionCapture = 12
+};
+
+// mailbox piece code: ChessPiece in the low 3 bits, color in bit 3
+inline constexpr int makePieceCode(int color, int piece) { return piece | (color << 3); }
+inline constexpr int pieceTypeOf(int code) { return code & 7; }
+inline constexpr int pieceColorOf(int code) { return code >> 3; }
+
+// material by ChessPiece, for exchanges, capture ordering and pruning margins.
+// The king is worth more than anything it could win.
+inline constexpr int PieceValues[7] = { 0, 100, 320, 330, 500, 900, 20000 };
+
+//
+// 16-bit move: from square in bits 0-5, to square in bits 6-11, MoveFlag in bits 12-15.
+// The moving and captured pieces aren't stored; they are decoded against the position.
+// All zero (a1a1) is never a legal move and is used as the null move.
+//
+class ChessMove
+{
+public:
+    constexpr ChessMove() : _data(0) {}
+    constexpr ChessMove(int from, int to, int flags = MoveQuiet)
+        : _data(static_cast<uint16_t>(from | (to << 6) | (flags << 12))) {}
+
+    static constexpr ChessMove fromRaw(uint16_t raw)
+    {
+        ChessMove move;
+        move._data = raw;
+        return move;
+    }
+
+    int from() const { return _data & 63; }
+    int to() const { return (_data >> 6) & 63; }
+    int flags() const { return _data >> 12; }
+    uint16_t raw() const { return _data; }
+
+    bool isNull() const { return _data == 0; }
+    bool isCapture() const { return (flags() & MoveCapture) != 0; }
+    bool isPromotion() const { return (flags() & MovePromotion) != 0; }
+    bool isEnPassant() const { return flags() == MoveEnPassant; }
+    bool isDoublePush() const { return flags() == MoveDoublePush; }
+    bool isCastle() const { return flags() == MoveKingCastle || flags() == MoveQueenCastle; }
+    int promotionPiece() const { return isPromotion() ? Knight + (flags() & 3) : NoPiece; }
+
+    bool operator==(const ChessMove &other) const = default;
+
+private:
+    uint16_t _data;
+};
+
+static_assert(sizeof(ChessMove) == 2, "ChessMove must stay 16 bits");
+
+//
+// fixed capacity move list that lives on the stack, so generating moves at a
+// search node never allocates. 256 is above the most moves any legal position has.
+//
+class MoveList
+{
+public:
+    static constexpr int Capacity = 256;
+
+    void push_back(ChessMove move) { _moves[_size++] = move; }
+    void clear() { _size = 0; }
+    int size() const { return _size; }
+    bool empty() const { return _size == 0; }
+
+    ChessMove &operator[](int index) { return _moves[index]; }
+    const ChessMove &operator[](int index) const { return _moves[index]; }
+    ChessMove *begin() { return _moves; }
+    ChessMove *end() { return _moves + _size; }
+    const ChessMove *begin() const { return _moves; }
+    const ChessMove *end() const { return _moves + _size; }
+
+private:
+    ChessMove _moves[Capacity];
+    int _size = 0;
+};
+
+// long algebraic (UCI) notation, e.g. e2e4 or e7e8q
+std::string moveToString(ChessMove move);
+
+// which moves to generate; staged search generates captures and quiets separately
+enum MoveGenType
+{
+    GenAll,
+    GenCaptures,    // captures, en passant and all promotions
+    GenQuiets       // everything else, including castling
+};
+
+// what makeMove can't recompute, saved so unmakeMove can restore it exactly
+struct UndoInfo
+{
+    ChessMove move;
+    uint8_t captured;        // piece code, 0 if the move wasn't a capture
+    uint8_t castlingRights;
+    int8_t enPassantSquare;
+    uint16_t halfmoveClock;
+    uint64_t key;
+};
+
+//
+// GUI independent chess position: twelve piece bitboards plus a mailbox for
+// piece-on-square lookups, and the side to move, castling and en passant state.
+// The search and move generator run on this; the Grid is only synced from it.
+//
+class ChessPosition
+{
+public:
+    ChessPosition();
+
+    void clear();
+    // accepts a full FEN or just the piece placement field
+    bool setFromFEN(const std::string &fen);
+    std::string toFEN() const;
+
+    Bitboard pieces(int color, int piece) const { return _pieces[color][piece - 1]; }
+    Bitboard occupancy(int color) const { return _occupancy[color]; }
+    Bitboard occupied() const { return _occupied; }
+    int pieceAt(int square) const { return _board[square]; }
+
+    int sideToMove() const { return _sideToMove; }
+    int castlingRights() const { return _castlingRights; }
+    int enPassantSquare() const { return _enPassantSquare; }
+    int halfmoveClock() const { return _halfmoveClock; }
+    int fullmoveNumber() const { return _fullmoveNumber; }
+    int kingSquare(int color) const { return _kingSquare[color]; }
+
+    // Zobrist key of pieces, side to move, castling rights and (capturable) en passant file,
+    // kept up to date by makeMove/unmakeMove. computeKey rebuilds it from scratch.
+    uint64_t key() const { return _key; }
+    uint64_t computeKey() const;
+    // Zobrist key of the pawns alone, for the pawn structure cache; 0 with no pawns on the board
+    uint64_t pawnKey() const { return _pawnKey; }
+
+    // running material + piece-square sums from white's point of view, and the
+    // game phase, updated as pieces are put and removed (see Eval)
+    int mgScore() const { return _mgScore; }
+    int egScore() const { return _egScore; }
+    int phase() const { return _phase; }
+
+    // pieces a move involves, decoded against this position before it is made
+    int movingPiece(ChessMove move) const { return _board[move.from()]; }
+    int capturedPiece(ChessMove move) const
+    {
+        return move.isEnPassant() ? makePieceCode(_sideToMove ^ 1, Pawn) : _board[move.to()];
+    }
+
+    // every square the given side attacks, computed once per position on first use.
+    // Sliders see through the enemy king, so the map also tells which squares
+    // that king can't step back to along a checking line.
+    Bitboard attacks(int color) const;
+    // pieces of both colors attacking a square, given an occupancy
+    Bitboard attackersTo(int square, Bitboard occupied) const;
+    // pieces of the given color that are absolutely pinned to their king
+    Bitboard pinnedPieces(int color) const;
+    bool inCheck() const;
+    // static exchange evaluation: material the side to move ends up with if both sides keep
+    // recapturing on the move's target square with their least valuable attacker, either
+    // side free to stop. X-ray sliders join as the pieces in front of them leave.
+    int staticExchange(ChessMove move) const;
+
+    void generateLegalMoves(MoveList &moves, MoveGenType type = GenAll) const;
+    // whether a move from elsewhere (hash table, killer slot) is legal here
+    bool isLegal(ChessMove move) const;
+
+    // makeMove pushes an UndoInfo on the position's own fixed-size stack and
+    // unmakeMove pops it, so a search can walk the tree on a single position
+    void makeMove(ChessMove move);
+    void unmakeMove();
+    // pass the turn, for null-move pruning; must not be called while in check
+    void makeNullMove();
+    void unmakeNullMove();
+    int historySize() const { return _historySize; }
+    // whether the side has anything besides pawns and its king, the null-move zugzwang guard
+    bool hasNonPawnMaterial(int color) const
+    {
+        return (pieces(color, Knight) | pieces(color, Bishop) | pieces(color, Rook) | pieces(color, Queen)) != 0;
+    }
+
+    static constexpr int MaxHistory = 1024;
+
+private:
+    void putPiece(int square, int code);
+    void removePiece(int square);
+    void movePiece(int from, int to);
+
+    void generateMoves(MoveList &moves, MoveGenType type, Bitboard fromSquares) const;
+    // mask limits the destinations to check evasions and the pin line, if any
+    void generatePawnMoves(int square, Bitboard mask, MoveGenType type, MoveList &moves) const;
+    void generateKnightMoves(int square, Bitboard mask, MoveList &moves) const;
+    void generateBishopMoves(int square, Bitboard mask, MoveList &moves) const;
+    void generateRookMoves(int square, Bitboard mask, MoveList &moves) const;
+    void generateQueenMoves(int square, Bitboard mask, MoveList &moves) const;
+    void generateKingMoves(int square, Bitboard checkers, Bitboard targets, MoveList &moves) const;
+    void addMoves(int from, Bitboard targets, MoveList &moves) const;
+    Bitboard computeAttacks(int color) const;
+    uint64_t enPassantKey() const;
+    void invalidateAttacks() { _attacksValid = 0; }
+
+    Bitboard _pieces[2][6];
+    Bitboard _occupancy[2];
+    Bitboard _occupied;
+    uint8_t _board[64];
+    int _kingSquare[2];
+
+    UndoInfo _history[MaxHistory];
+    int _historySize;
+
+    mutable Bitboard _attacks[2];
+    mutable int _attacksValid;  // bit per color
+
+    int _sideToMove;
+    int _castlingRights;
+    int _enPassantSquare;   // square a pawn would land on when capturing en passant, -1 if none
+    int _halfmoveClock;
+    int _fullmoveNumber;
+    uint64_t _key;
+    uint64_t _pawnKey;
+    int _mgScore;
+    int _egScore;
+    int _phase;
+};
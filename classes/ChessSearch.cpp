@@ -0,0 +1,162 @@
+#include "ChessSearch.h"
+#include "Attacks.h"
+#include "Nnue.h"
+#include "SearchWorker.h"
+#include <algorithm>
+#include <cstdlib>
+#include <thread>
+
+ChessSearch::ChessSearch()
+{
+    Attacks::init();
+    setThreads(1);
+}
+
+ChessSearch::~ChessSearch() = default;
+
+void ChessSearch::setThreads(int count)
+{
+    count = std::max(count, 1);
+    _workers.clear();
+    for (int i = 0; i < count; i++) {
+        _workers.push_back(std::make_unique<SearchWorker>(*this, i));
+    }
+}
+
+bool ChessSearch::loadNetwork(const std::string& path)
+{
+    auto network = std::make_unique<Nnue::Network>();
+    if (!network->load(path)) {
+        return false;
+    }
+    _network = std::move(network);
+    _evalCache.clear();
+    return true;
+}
+
+void ChessSearch::unloadNetwork()
+{
+    _network.reset();
+    _evalCache.clear();
+}
+
+void ChessSearch::clearHash()
+{
+    _tt.clear();
+    _evalCache.clear();
+    for (auto& worker : _workers) {
+        worker->resetStats();
+    }
+}
+
+TTStats ChessSearch::ttStats() const
+{
+    TTStats total;
+    for (const auto& worker : _workers) {
+        const TTStats& stats = worker->ttStats();
+        total.probes += stats.probes;
+        total.hits += stats.hits;
+        total.stores += stats.stores;
+        total.collisions += stats.collisions;
+    }
+    return total;
+}
+
+EvalCacheStats ChessSearch::evalCacheStats() const
+{
+    EvalCacheStats total;
+    for (const auto& worker : _workers) {
+        total.probes += worker->evalStats().probes;
+        total.hits += worker->evalStats().hits;
+    }
+    return total;
+}
+
+// mate scores count plies from the root; the table stores them counted from the node
+// so a mate found through one path is still right when reached through another
+int ChessSearch::scoreToTT(int score, int ply)
+{
+    return score > MateBound ? score + ply : score < -MateBound ? score - ply : score;
+}
+
+int ChessSearch::scoreFromTT(int score, int ply)
+{
+    return score > MateBound ? score - ply : score < -MateBound ? score + ply : score;
+}
+
+void ChessSearch::checkLimits()
+{
+    if (_limits.cancel && _limits.cancel->load(std::memory_order_relaxed)) {
+        stop();
+    }
+    if (_limits.maxNodes) {
+        uint64_t nodes = 0;
+        for (const auto& worker : _workers) {
+            nodes += worker->nodes();
+        }
+        if (nodes >= _limits.maxNodes) {
+            stop();
+        }
+    }
+    if (_limits.moveTimeMs) {
+        auto elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - _startTime);
+        if (elapsed.count() >= _limits.moveTimeMs) {
+            stop();
+        }
+    }
+}
+
+int ChessSearch::maxDepth() const
+{
+    if (!_limits.maxDepth && !_limits.maxNodes && !_limits.moveTimeMs) {
+        return DefaultDepth;
+    }
+    return _limits.maxDepth > 0 ? std::min(_limits.maxDepth, MaxPly - 1) : MaxPly - 1;
+}
+
+// Find the best move with iterative deepening, on every search thread
+ChessMove ChessSearch::findBestMove(const ChessPosition& root, const SearchLimits& limits)
+{
+    _limits = limits;
+    _startTime = std::chrono::steady_clock::now();
+    _stop.store(false, std::memory_order_relaxed);
+    _result = SearchResult();
+
+    MoveList moves;
+    root.generateLegalMoves(moves);
+    if (moves.empty()) {
+        return ChessMove();
+    }
+
+    // Each worker searches its own copy, so the caller's position is never disturbed
+    _tt.newSearch();
+    for (auto& worker : _workers) {
+        worker->start(root, moves, static_cast<unsigned>(rand()));
+    }
+
+    // Helpers run until the main thread is done, then get stopped
+    std::vector<std::thread> helpers;
+    for (size_t i = 1; i < _workers.size(); i++) {
+        helpers.emplace_back([worker = _workers[i].get()] { worker->iterate(); });
+    }
+    _workers[0]->iterate();
+    stop();
+    for (auto& helper : helpers) {
+        helper.join();
+    }
+
+    // A helper that completed a deeper iteration than the main thread has the better answer
+    const SearchWorker* best = _workers[0].get();
+    for (const auto& worker : _workers) {
+        if (worker->result().depth > best->result().depth) {
+            best = worker.get();
+        }
+    }
+    _result = best->result();
+    _result.nodes = 0;
+    for (const auto& worker : _workers) {
+        _result.nodes += worker->nodes();
+    }
+    _result.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - _startTime).count();
+    return _result.bestMove;
+}
@@ -0,0 +1,109 @@
+#pragma once
+
+#include "ChessPosition.h"
+#include "EvalCache.h"
+#include "TranspositionTable.h"
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+class SearchWorker;
+namespace Nnue { class Network; }
+
+// how long findBestMove may think; whichever limit is hit first ends the search,
+// and 0 leaves a limit off. With none set the search stops at DefaultDepth.
+struct SearchLimits
+{
+    int maxDepth = 0;
+    uint64_t maxNodes = 0;
+    int moveTimeMs = 0;
+    // cancellation token: set from another thread to abandon the search early
+    const std::atomic<bool> *cancel = nullptr;
+};
+
+// outcome of the deepest completed iteration
+struct SearchResult
+{
+    ChessMove bestMove;
+    int score = 0;
+    int depth = 0;
+    uint64_t nodes = 0;
+    double seconds = 0.0;
+};
+
+//
+// GUI independent alpha-beta search over a ChessPosition. Chess owns one and
+// asks it for a move; the headless tools can drive it directly.
+//
+// With more than one thread it runs Lazy SMP: every thread searches the same
+// root independently and they cooperate only through the shared transposition
+// table, each finding results the others can reuse.
+//
+class ChessSearch
+{
+public:
+    static constexpr int MaxPly = 128;
+    static constexpr int MateScore = 50000;
+    // scores beyond this are mates, stored relative to the node rather than the root
+    static constexpr int MateBound = MateScore - MaxPly;
+    // every score lies strictly inside (-Infinity, Infinity), so negating a bound never overflows
+    static constexpr int Infinity = MateScore + 1;
+    static constexpr int DefaultDepth = 6;
+
+    ChessSearch();
+    ~ChessSearch();
+
+    // iterative deepening: depth 1, 2, 3... until a limit runs out. The move from the
+    // last completed iteration is returned, so stopping early always has an answer.
+    // Null if the side to move has no moves.
+    ChessMove findBestMove(const ChessPosition &position, const SearchLimits &limits = SearchLimits());
+    const SearchResult &lastResult() const { return _result; }
+    // ends a running search as soon as possible; safe to call from another thread
+    void stop() { _stop.store(true, std::memory_order_relaxed); }
+
+    // search threads, the calling thread included
+    void setThreads(int count);
+    int threads() const { return static_cast<int>(_workers.size()); }
+
+    // optional NNUE evaluation, used in place of the hand written one while loaded.
+    // Not while a search is running.
+    bool loadNetwork(const std::string &path);
+    void unloadNetwork();
+    bool hasNetwork() const { return _network != nullptr; }
+
+    // the table is kept between searches so each move builds on the last
+    void setHashSize(size_t sizeMB) { _tt.resize(sizeMB); }
+    // forget everything earlier searches stored, evaluations included
+    void clearHash();
+    const TranspositionTable &transpositionTable() const { return _tt; }
+    // probes and stores summed over the search threads since the hash was last cleared
+    TTStats ttStats() const;
+    // static evaluations, also kept between searches
+    void setEvalCacheSize(size_t sizeMB) { _evalCache.resize(sizeMB); }
+    const EvalCache &evalCache() const { return _evalCache; }
+    // probes and hits summed over the search threads since the hash was last cleared
+    EvalCacheStats evalCacheStats() const;
+
+private:
+    friend class SearchWorker;
+
+    static int scoreToTT(int score, int ply);
+    static int scoreFromTT(int score, int ply);
+    // checks the time and the node count summed over all threads; stops the search once exceeded
+    void checkLimits();
+    bool stopped() const { return _stop.load(std::memory_order_relaxed); }
+    int maxDepth() const;
+
+    TranspositionTable _tt;
+    EvalCache _evalCache;
+    std::vector<std::unique_ptr<SearchWorker>> _workers;
+    std::unique_ptr<Nnue::Network> _network;
+
+    SearchLimits _limits;
+    SearchResult _result;
+    std::chrono::steady_clock::time_point _startTime;
+    std::atomic<bool> _stop{false};
+};
@@ -0,0 +1,27 @@
+#include "EvalCache.h"
+#include <algorithm>
+
+EvalCache::EvalCache(size_t sizeMB)
+{
+    resize(sizeMB);
+}
+
+void EvalCache::resize(size_t sizeMB)
+{
+    size_t bytes = std::max<size_t>(sizeMB, 1) << 20;
+    size_t count = 1;
+    while (count * 2 * sizeof(std::atomic<uint64_t>) <= bytes) {
+        count *= 2;
+    }
+    _entries.reset(new std::atomic<uint64_t>[count]);
+    _mask = count - 1;
+    clear();
+}
+
+void EvalCache::clear()
+{
+    // an all-zero entry only matches a key whose top 48 bits are zero
+    for (uint64_t i = 0; i <= _mask; i++) {
+        _entries[i].store(0, std::memory_order_relaxed);
+    }
+}
@@ -0,0 +1,54 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+
+// counted by each search thread on its own, so the threads don't contend on a shared line
+struct EvalCacheStats
+{
+    uint64_t probes = 0;
+    uint64_t hits = 0;
+};
+
+//
+// direct-mapped cache of static evaluations by position key, shared by every search
+// thread. The same leaf is reached through different move orders, in quiescence and
+// at reduced depths, and the transposition table doesn't always hold it.
+// Each entry is a single 64-bit word, the key's top 48 bits over a 16-bit score,
+// so it is read and written whole and needs no locking.
+//
+class EvalCache
+{
+public:
+    static constexpr size_t DefaultSizeMB = 4;
+
+    explicit EvalCache(size_t sizeMB = DefaultSizeMB);
+
+    // reallocates (and so clears) the cache, rounded down to a power of two entries
+    void resize(size_t sizeMB);
+    void clear();
+
+    // scores are from the side to move's point of view and must fit in 16 bits
+    bool probe(uint64_t key, int &score) const
+    {
+        uint64_t entry = _entries[key & _mask].load(std::memory_order_relaxed);
+        if ((entry ^ key) & TagMask) {
+            return false;
+        }
+        score = static_cast<int16_t>(entry & ~TagMask);
+        return true;
+    }
+
+    void store(uint64_t key, int score)
+    {
+        _entries[key & _mask].store((key & TagMask) | static_cast<uint16_t>(score), std::memory_order_relaxed);
+    }
+
+private:
+    static constexpr uint64_t TagMask = ~0xFFFFULL;
+
+    std::unique_ptr<std::atomic<uint64_t>[]> _entries;
+    uint64_t _mask = 0;
+};
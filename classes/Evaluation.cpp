@@ -0,0 +1,218 @@
+#include "Evaluation.h"
+#include "Attacks.h"
+#include "ChessPosition.h"
+#include "EvalWeights.h"
+#include "PawnTable.h"
+#include <algorithm>
+#include <mutex>
+
+namespace Eval
+{
+    Params Weights;
+    int PieceSquareMg[16][64];
+    int PieceSquareEg[16][64];
+
+    namespace
+    {
+        Bitboard AdjacentFiles[8];
+        // squares ahead of a pawn on its own and the adjacent files: no enemy pawn there means passed
+        Bitboard PassedSpan[2][64];
+        // squares ahead of a pawn on its own file
+        Bitboard FrontFile[2][64];
+
+        template <size_t N>
+        void copyWeights(const int (&from)[N], int (&to)[N])
+        {
+            std::copy(std::begin(from), std::end(from), to);
+        }
+
+        int relativeRank(int color, int square)
+        {
+            return color == White ? rankOf(square) : 7 - rankOf(square);
+        }
+
+        // doubled, isolated and passed pawns: everything that depends on the pawns alone
+        void evaluatePawns(const ChessPosition &position, PawnEntry &entry, Trace *trace)
+        {
+            int mg = 0;
+            int eg = 0;
+            for (int color : { White, Black }) {
+                Bitboard own = position.pieces(color, Pawn);
+                Bitboard theirs = position.pieces(color ^ 1, Pawn);
+                int sign = color == White ? 1 : -1;
+                entry.passed[color] = 0;
+
+                Bitboard pawns = own;
+                while (pawns) {
+                    int square = popLsb(pawns);
+                    int file = fileOf(square);
+                    // the rear pawn of a doubled pair takes the penalty, and can't be passed
+                    bool doubled = (own & FrontFile[color][square]) != 0;
+                    if (doubled) {
+                        mg += sign * Weights.doubledMg;
+                        eg += sign * Weights.doubledEg;
+                        if (trace) trace->doubled += sign;
+                    }
+                    if (!(own & AdjacentFiles[file])) {
+                        mg += sign * Weights.isolatedMg;
+                        eg += sign * Weights.isolatedEg;
+                        if (trace) trace->isolated += sign;
+                    }
+                    if (!doubled && !(theirs & PassedSpan[color][square])) {
+                        int rank = relativeRank(color, square);
+                        entry.passed[color] |= squareBB(square);
+                        mg += sign * Weights.passedMg[rank];
+                        eg += sign * Weights.passedEg[rank];
+                        if (trace) trace->passed[rank] += sign;
+                    }
+                }
+            }
+            entry.mg = static_cast<int16_t>(mg);
+            entry.eg = static_cast<int16_t>(eg);
+        }
+
+        // own pawns one and two ranks in front of the king, on its file and the two beside it
+        int kingShield(const ChessPosition &position, int color, int king, Trace *trace)
+        {
+            Bitboard own = position.pieces(color, Pawn);
+            int forward = color == White ? 1 : -1;
+            int shield = 0;
+            for (int file = std::max(fileOf(king) - 1, 0); file <= std::min(fileOf(king) + 1, 7); file++) {
+                for (int step = 1; step <= 2; step++) {
+                    int rank = rankOf(king) + step * forward;
+                    if (rank >= 0 && rank < 8 && (own & squareBB(squareOf(file, rank)))) {
+                        shield += Weights.shieldPawn[step - 1];
+                        if (trace) trace->shieldPawn[step - 1] += color == White ? 1 : -1;
+                    }
+                }
+            }
+            return shield;
+        }
+
+        int evaluateTerms(const ChessPosition &position, PawnTable *pawns, Trace *trace)
+        {
+            PawnEntry scratch;
+            PawnEntry *entry = &scratch;
+            bool hit = false;
+            if (pawns) {
+                entry = &pawns->probe(position.pawnKey(), hit);
+            }
+            if (!hit) {
+                evaluatePawns(position, *entry, trace);
+                entry->key = position.pawnKey();
+                entry->shieldKing[White] = entry->shieldKing[Black] = -1;
+            }
+
+            int mg = position.mgScore() + entry->mg;
+            int eg = position.egScore() + entry->eg;
+
+            for (int side : { White, Black }) {
+                int king = position.kingSquare(side);
+                if (king < 0) continue;
+                int sign = side == White ? 1 : -1;
+
+                // the shield only changes when the king moves, so it is cached alongside the structure
+                if (entry->shieldKing[side] != king) {
+                    entry->shieldKing[side] = static_cast<int8_t>(king);
+                    entry->shield[side] = static_cast<int16_t>(kingShield(position, side, king, trace));
+                }
+                mg += sign * entry->shield[side];
+
+                // King safety: penalty for each square next to the king the opponent attacks
+                int attacked = popCount(Attacks::king(king) & position.attacks(side ^ 1));
+                mg -= sign * attacked * Weights.kingZoneAttack;
+                eg -= sign * attacked * Weights.kingZoneAttack;
+                if (trace) trace->kingZoneAttack -= sign * attacked;
+
+                // passed pawns race better with our king close and theirs far away
+                int enemyKing = position.kingSquare(side ^ 1);
+                if (enemyKing < 0) continue;
+                Bitboard passed = entry->passed[side];
+                while (passed) {
+                    int stop = popLsb(passed) + (side == White ? 8 : -8);
+                    int closer = distance(enemyKing, stop) - distance(king, stop);
+                    eg += sign * closer * Weights.passedKingDistance;
+                    if (trace) trace->passedKingDistance += sign * closer;
+                }
+            }
+
+            // tapered: midgame weights with all the pieces on, sliding to endgame weights as they come off
+            int phase = std::min(position.phase(), MaxPhase);
+            return (mg * phase + eg * (MaxPhase - phase)) / MaxPhase;
+        }
+    }
+
+    void init()
+    {
+        static std::once_flag initialized;
+        std::call_once(initialized, [] {
+            copyWeights(EvalWeights::MaterialMg, Weights.materialMg);
+            copyWeights(EvalWeights::MaterialEg, Weights.materialEg);
+            for (int piece = 0; piece < 7; piece++) {
+                copyWeights(EvalWeights::PstMg[piece], Weights.pstMg[piece]);
+                copyWeights(EvalWeights::PstEg[piece], Weights.pstEg[piece]);
+            }
+            Weights.kingZoneAttack = EvalWeights::KingZoneAttack;
+            Weights.doubledMg = EvalWeights::DoubledMg;
+            Weights.doubledEg = EvalWeights::DoubledEg;
+            Weights.isolatedMg = EvalWeights::IsolatedMg;
+            Weights.isolatedEg = EvalWeights::IsolatedEg;
+            copyWeights(EvalWeights::PassedMg, Weights.passedMg);
+            copyWeights(EvalWeights::PassedEg, Weights.passedEg);
+            Weights.passedKingDistance = EvalWeights::PassedKingDistance;
+            copyWeights(EvalWeights::ShieldPawn, Weights.shieldPawn);
+
+            for (int file = 0; file < 8; file++) {
+                AdjacentFiles[file] = (file > 0 ? FileABB << (file - 1) : 0) | (file < 7 ? FileABB << (file + 1) : 0);
+            }
+            for (int square = 0; square < 64; square++) {
+                Bitboard file = FileABB << fileOf(square);
+                Bitboard above = rankOf(square) < 7 ? ~0ULL << (8 * (rankOf(square) + 1)) : 0;
+                Bitboard below = (1ULL << (8 * rankOf(square))) - 1;
+                FrontFile[White][square] = file & above;
+                FrontFile[Black][square] = file & below;
+                PassedSpan[White][square] = (file | AdjacentFiles[fileOf(square)]) & above;
+                PassedSpan[Black][square] = (file | AdjacentFiles[fileOf(square)]) & below;
+            }
+            rebuildTables();
+        });
+    }
+
+    void rebuildTables()
+    {
+        for (auto &squares : PieceSquareMg) std::fill(std::begin(squares), std::end(squares), 0);
+        for (auto &squares : PieceSquareEg) std::fill(std::begin(squares), std::end(squares), 0);
+
+        for (int piece = Pawn; piece <= King; piece++) {
+            for (int square = 0; square < 64; square++) {
+                // tables are printed rank 8 first: white reads them flipped, black as they are
+                int white = makePieceCode(White, piece);
+                int black = makePieceCode(Black, piece);
+                PieceSquareMg[white][square] = Weights.materialMg[piece] + Weights.pstMg[piece][square ^ 56];
+                PieceSquareEg[white][square] = Weights.materialEg[piece] + Weights.pstEg[piece][square ^ 56];
+                PieceSquareMg[black][square] = -(Weights.materialMg[piece] + Weights.pstMg[piece][square]);
+                PieceSquareEg[black][square] = -(Weights.materialEg[piece] + Weights.pstEg[piece][square]);
+            }
+        }
+    }
+
+    int evaluate(const ChessPosition &position, PawnTable *pawns)
+    {
+        return evaluateTerms(position, pawns, nullptr);
+    }
+
+    void trace(const ChessPosition &position, Trace &trace)
+    {
+        trace = Trace{};
+        for (int square = 0; square < 64; square++) {
+            int code = position.pieceAt(square);
+            if (code == 0) continue;
+            int piece = pieceTypeOf(code);
+            bool white = pieceColorOf(code) == White;
+            trace.material[piece] += white ? 1 : -1;
+            trace.pst[piece][white ? square ^ 56 : square] += white ? 1 : -1;
+        }
+        trace.phase = std::min(position.phase(), MaxPhase);
+        evaluateTerms(position, nullptr, &trace);
+    }
+}
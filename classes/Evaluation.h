@@ -0,0 +1,67 @@
+#pragma once
+
+class ChessPosition;
+class PawnTable;
+
+//
+// static evaluation. Material and piece-square values are kept per position as
+// running midgame and endgame sums by ChessPosition itself (see putPiece), so
+// evaluating is mostly blending those two by the game phase.
+// Eval::init() must be called once before positions are set up.
+//
+namespace Eval
+{
+    // phase counts the non-pawn material left: MaxPhase in the opening, 0 with only kings and pawns
+    inline constexpr int MaxPhase = 24;
+    inline constexpr int PhaseWeight[7] = { 0, 0, 1, 1, 2, 4, 0 };
+
+    // the weights in use, loaded from EvalWeights; the tuner changes them and calls rebuildTables()
+    struct Params
+    {
+        int materialMg[7];
+        int materialEg[7];
+        int pstMg[7][64];   // rank 8 first, as in EvalWeights
+        int pstEg[7][64];
+        int kingZoneAttack;
+        int doubledMg;
+        int doubledEg;
+        int isolatedMg;
+        int isolatedEg;
+        int passedMg[8];        // by rank from the pawn's own side
+        int passedEg[8];
+        int passedKingDistance;
+        int shieldPawn[2];
+    };
+    extern Params Weights;
+
+    // material plus piece-square value by mailbox piece code and square (a1 = 0),
+    // positive for white pieces and negative for black
+    extern int PieceSquareMg[16][64];
+    extern int PieceSquareEg[16][64];
+
+    void init();
+    void rebuildTables();
+
+    // static score from white's point of view. The pawn structure terms are looked up
+    // in the pawn table when one is given, and worked out from scratch otherwise.
+    int evaluate(const ChessPosition &position, PawnTable *pawns = nullptr);
+
+    // how often each weight counts toward a position's score, white's count minus black's.
+    // The score is linear in the weights, so the tuner can rescore a traced position under
+    // any weights without the position itself. Coefficients apply to the midgame and endgame
+    // weight alike, except shieldPawn (midgame only), passedKingDistance (endgame only) and
+    // kingZoneAttack, one weight used in both.
+    struct Trace
+    {
+        int material[7];
+        int pst[7][64];     // indexed like Params::pstMg
+        int kingZoneAttack;
+        int doubled;
+        int isolated;
+        int passed[8];
+        int passedKingDistance;
+        int shieldPawn[2];
+        int phase;          // capped at MaxPhase, as evaluate does
+    };
+    void trace(const ChessPosition &position, Trace &trace);
+}
@@ -15,6 +15,8 @@ Game::Game()
 	_gameOptions.rowY = 0;
 	_gameOptions.score = 0;
 	_gameOptions.AIDepthSearches = 0;
+	_gameOptions.AIMAXDepth = 0;
+	_gameOptions.AIMoveTimeMs = 0;
 	_gameOptions.AIvsAI = false;
 
 	_table = nullptr;
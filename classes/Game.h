@@ -39,8 +39,9 @@ struct GameOptions
 	int gameNumber;
 	unsigned int currentTurnNo;
 	int score;
-	int AIDepthSearches;
-	int AIMAXDepth;
+	int AIDepthSearches;	// node budget per AI move in thousands, 0 for none
+	int AIMAXDepth;			// deepest search iteration, 0 for no cap
+	int AIMoveTimeMs;		// thinking time per AI move, 0 for no limit
 	bool AIvsAI;
 };
 
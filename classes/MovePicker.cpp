@@ -0,0 +1,127 @@
+#include "MovePicker.h"
+#include <utility>
+
+MovePicker::MovePicker(const ChessPosition &position, ChessMove ttMove, const ChessMove killers[2],
+                       const ButterflyHistory *history)
+    : _position(position), _history(history), _stage(StageTTMove), _killerIndex(0), _capturesOnly(false), _current(0), _badCaptureIndex(0)
+{
+    _ttMove = position.isLegal(ttMove) ? ttMove : ChessMove();
+    _killers[0] = killers ? killers[0] : ChessMove();
+    _killers[1] = killers ? killers[1] : ChessMove();
+    if (_ttMove.isNull()) {
+        _stage = StageGenerateCaptures;
+    }
+}
+
+MovePicker::MovePicker(const ChessPosition &position)
+    : _position(position), _history(nullptr), _stage(StageGenerateCaptures), _killerIndex(0), _capturesOnly(true), _current(0), _badCaptureIndex(0)
+{
+}
+
+// most valuable victim first, and among equal victims the least valuable attacker
+int MovePicker::captureScore(ChessMove move) const
+{
+    int score = PieceValues[pieceTypeOf(_position.capturedPiece(move))] * 8 - pieceTypeOf(_position.movingPiece(move));
+    if (move.isPromotion()) {
+        score += PieceValues[move.promotionPiece()] * 8;
+    }
+    return score;
+}
+
+int MovePicker::quietScore(ChessMove move) const
+{
+    return _history ? (*_history)[_position.sideToMove()][move.from()][move.to()] : 0;
+}
+
+ChessMove MovePicker::pickBest()
+{
+    int best = _current;
+    for (int i = _current + 1; i < _moves.size(); i++) {
+        if (_scores[i] > _scores[best]) {
+            best = i;
+        }
+    }
+    std::swap(_moves[_current], _moves[best]);
+    std::swap(_scores[_current], _scores[best]);
+    return _moves[_current++];
+}
+
+ChessMove MovePicker::next()
+{
+    switch (_stage) {
+        case StageTTMove:
+            _stage = StageGenerateCaptures;
+            return _ttMove;
+
+        case StageGenerateCaptures:
+            _position.generateLegalMoves(_moves, GenCaptures);
+            for (int i = 0; i < _moves.size(); i++) {
+                _scores[i] = captureScore(_moves[i]);
+            }
+            _current = 0;
+            _stage = StageCaptures;
+            [[fallthrough]];
+
+        case StageCaptures:
+            while (_current < _moves.size()) {
+                ChessMove move = pickBest();
+                if (move == _ttMove) {
+                    continue;
+                }
+                // quiescence prunes losing captures itself, the main search tries them last
+                if (!_capturesOnly && _position.staticExchange(move) < 0) {
+                    _badCaptures.push_back(move);
+                    continue;
+                }
+                return move;
+            }
+            if (_capturesOnly) {
+                _stage = StageDone;
+                return ChessMove();
+            }
+            _stage = StageKillers;
+            [[fallthrough]];
+
+        case StageKillers:
+            // killers are quiet moves that cut off at this ply in a sibling node
+            while (_killerIndex < 2) {
+                ChessMove killer = _killers[_killerIndex++];
+                if (!killer.isNull() && killer != _ttMove && !killer.isCapture() && !killer.isPromotion() &&
+                    _position.isLegal(killer)) {
+                    return killer;
+                }
+            }
+            _stage = StageGenerateQuiets;
+            [[fallthrough]];
+
+        case StageGenerateQuiets:
+            _moves.clear();
+            _position.generateLegalMoves(_moves, GenQuiets);
+            for (int i = 0; i < _moves.size(); i++) {
+                _scores[i] = quietScore(_moves[i]);
+            }
+            _current = 0;
+            _stage = StageQuiets;
+            [[fallthrough]];
+
+        case StageQuiets:
+            while (_current < _moves.size()) {
+                ChessMove move = pickBest();
+                if (move != _ttMove && !isKiller(move)) {
+                    return move;
+                }
+            }
+            _stage = StageBadCaptures;
+            [[fallthrough]];
+
+        case StageBadCaptures:
+            if (_badCaptureIndex < _badCaptures.size()) {
+                return _badCaptures[_badCaptureIndex++];
+            }
+            _stage = StageDone;
+            [[fallthrough]];
+
+        default:
+            return ChessMove();
+    }
+}
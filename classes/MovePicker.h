@@ -0,0 +1,63 @@
+#pragma once
+
+#include "ChessPosition.h"
+
+// butterfly history: per side, a score for each from/to pair that rises when the
+// quiet move causes a beta cutoff and falls when it is tried without one
+using ButterflyHistory = int[2][64][64];
+
+//
+// hands out a node's moves one at a time, best candidates first, generating
+// each group only when the previous one is used up. A beta cutoff on the hash
+// move or an early capture means the quiet moves are never generated at all.
+//
+//   hash move -> winning and even captures (MVV-LVA) -> killers -> quiet moves (by history)
+//   -> captures that lose material by static exchange
+//
+class MovePicker
+{
+public:
+    // ttMove and killers may be null or come from other positions; they are checked for legality.
+    // Without a history table quiet moves come in generation order.
+    MovePicker(const ChessPosition &position, ChessMove ttMove, const ChessMove killers[2],
+               const ButterflyHistory *history = nullptr);
+    // quiescence search: captures and promotions only
+    explicit MovePicker(const ChessPosition &position);
+
+    // the next move to try, or a null move when there are none left
+    ChessMove next();
+
+private:
+    enum Stage
+    {
+        StageTTMove,
+        StageGenerateCaptures,
+        StageCaptures,
+        StageKillers,
+        StageGenerateQuiets,
+        StageQuiets,
+        StageBadCaptures,
+        StageDone
+    };
+
+    // selection sort one step at a time: most nodes cut off after a move or two,
+    // so sorting the whole list up front would be wasted work
+    ChessMove pickBest();
+    int captureScore(ChessMove move) const;
+    int quietScore(ChessMove move) const;
+    bool isKiller(ChessMove move) const { return move == _killers[0] || move == _killers[1]; }
+
+    const ChessPosition &_position;
+    ChessMove _ttMove;
+    ChessMove _killers[2];
+    const ButterflyHistory *_history;
+    int _stage;
+    int _killerIndex;
+    bool _capturesOnly;
+
+    MoveList _moves;
+    int _scores[MoveList::Capacity];
+    int _current;
+    MoveList _badCaptures;
+    int _badCaptureIndex;
+};
@@ -0,0 +1,456 @@
+#include "Nnue.h"
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+
+// the SIMD kernels are compiled for their instruction set function by function and
+// chosen when a network is loaded, so a portable build still uses them where the CPU can
+#if (defined(__x86_64__) || defined(__i386__)) && (defined(__GNUC__) || defined(__clang__))
+#define NNUE_X86_KERNELS 1
+#include <immintrin.h>
+#endif
+
+namespace Nnue
+{
+    namespace
+    {
+        // one implementation of the inner loops, for one instruction set
+        struct Kernels
+        {
+            const char *name;
+            void (*accumulate)(const int16_t *base, int16_t *out, const int16_t *const *added, int addedCount,
+                               const int16_t *const *removed, int removedCount);
+            void (*clippedRelu16)(const int16_t *in, uint8_t *out, int count);
+            void (*affine)(const uint8_t *in, int inputCount, const int8_t *weights, const int32_t *biases,
+                           int32_t *out, int outputCount);
+        };
+    }
+
+    struct Network::Parameters
+    {
+        const Kernels *kernels;
+        alignas(64) int16_t featureBiases[L1];
+        alignas(64) int16_t featureWeights[Inputs * L1];
+        alignas(64) int32_t hidden1Biases[L2];
+        alignas(64) int8_t hidden1Weights[L2 * 2 * L1];     // [output][input]
+        alignas(64) int32_t hidden2Biases[L3];
+        alignas(64) int8_t hidden2Weights[L3 * L2];
+        alignas(64) int32_t outputBias;
+        alignas(64) int8_t outputWeights[L3];
+    };
+
+    namespace
+    {
+        const char FileMagic[4] = { 'N', 'N', 'U', 'E' };
+        const uint32_t FileVersion = 1;
+
+        // out = base + the added rows - the removed rows, over one side's L1 values
+        void accumulateScalar(const int16_t *base, int16_t *out, const int16_t *const *added, int addedCount,
+                              const int16_t *const *removed, int removedCount)
+        {
+            std::memcpy(out, base, L1 * sizeof(int16_t));
+            for (int a = 0; a < addedCount; a++) {
+                for (int i = 0; i < L1; i++) out[i] += added[a][i];
+            }
+            for (int r = 0; r < removedCount; r++) {
+                for (int i = 0; i < L1; i++) out[i] -= removed[r][i];
+            }
+        }
+
+        // accumulator values clamped to 0..127, the first dense layer's int8 input
+        void clippedRelu16Scalar(const int16_t *in, uint8_t *out, int count)
+        {
+            for (int i = 0; i < count; i++) {
+                out[i] = static_cast<uint8_t>(std::clamp<int>(in[i], 0, 127));
+            }
+        }
+
+        // out = biases + weights * in, with uint8 inputs and int8 weights; inputCount is a multiple of 32
+        void affineScalar(const uint8_t *in, int inputCount, const int8_t *weights, const int32_t *biases,
+                          int32_t *out, int outputCount)
+        {
+            for (int o = 0; o < outputCount; o++) {
+                const int8_t *row = weights + o * inputCount;
+                int32_t sum = 0;
+                for (int i = 0; i < inputCount; i++) {
+                    sum += in[i] * row[i];
+                }
+                out[o] = biases[o] + sum;
+            }
+        }
+
+#if defined(NNUE_X86_KERNELS)
+        // the same three for AVX2 and SSE4.1. Inputs are at most 127, so the pairwise
+        // int16 sums of maddubs never saturate
+        __attribute__((target("avx2")))
+        void accumulateAvx2(const int16_t *base, int16_t *out, const int16_t *const *added, int addedCount,
+                            const int16_t *const *removed, int removedCount)
+        {
+            for (int i = 0; i < L1; i += 16) {
+                __m256i sum = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(base + i));
+                for (int a = 0; a < addedCount; a++) {
+                    sum = _mm256_add_epi16(sum, _mm256_loadu_si256(reinterpret_cast<const __m256i *>(added[a] + i)));
+                }
+                for (int r = 0; r < removedCount; r++) {
+                    sum = _mm256_sub_epi16(sum, _mm256_loadu_si256(reinterpret_cast<const __m256i *>(removed[r] + i)));
+                }
+                _mm256_storeu_si256(reinterpret_cast<__m256i *>(out + i), sum);
+            }
+        }
+
+        __attribute__((target("avx2")))
+        void clippedRelu16Avx2(const int16_t *in, uint8_t *out, int count)
+        {
+            const __m256i zero = _mm256_setzero_si256();
+            for (int i = 0; i < count; i += 32) {
+                __m256i a = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(in + i));
+                __m256i b = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(in + i + 16));
+                // packs works per 128-bit lane, the permute puts the halves back in order
+                __m256i packed = _mm256_permute4x64_epi64(_mm256_packs_epi16(a, b), 0xD8);
+                _mm256_storeu_si256(reinterpret_cast<__m256i *>(out + i), _mm256_max_epi8(packed, zero));
+            }
+        }
+
+        __attribute__((target("avx2")))
+        void affineAvx2(const uint8_t *in, int inputCount, const int8_t *weights, const int32_t *biases,
+                        int32_t *out, int outputCount)
+        {
+            const __m256i ones = _mm256_set1_epi16(1);
+            for (int o = 0; o < outputCount; o++) {
+                const int8_t *row = weights + o * inputCount;
+                __m256i sum = _mm256_setzero_si256();
+                for (int i = 0; i < inputCount; i += 32) {
+                    __m256i x = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(in + i));
+                    __m256i w = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(row + i));
+                    sum = _mm256_add_epi32(sum, _mm256_madd_epi16(_mm256_maddubs_epi16(x, w), ones));
+                }
+                __m128i total = _mm_add_epi32(_mm256_castsi256_si128(sum), _mm256_extracti128_si256(sum, 1));
+                total = _mm_add_epi32(total, _mm_shuffle_epi32(total, _MM_SHUFFLE(1, 0, 3, 2)));
+                total = _mm_add_epi32(total, _mm_shuffle_epi32(total, _MM_SHUFFLE(2, 3, 0, 1)));
+                out[o] = biases[o] + _mm_cvtsi128_si32(total);
+            }
+        }
+
+        __attribute__((target("sse4.1")))
+        void accumulateSse41(const int16_t *base, int16_t *out, const int16_t *const *added, int addedCount,
+                             const int16_t *const *removed, int removedCount)
+        {
+            for (int i = 0; i < L1; i += 8) {
+                __m128i sum = _mm_loadu_si128(reinterpret_cast<const __m128i *>(base + i));
+                for (int a = 0; a < addedCount; a++) {
+                    sum = _mm_add_epi16(sum, _mm_loadu_si128(reinterpret_cast<const __m128i *>(added[a] + i)));
+                }
+                for (int r = 0; r < removedCount; r++) {
+                    sum = _mm_sub_epi16(sum, _mm_loadu_si128(reinterpret_cast<const __m128i *>(removed[r] + i)));
+                }
+                _mm_storeu_si128(reinterpret_cast<__m128i *>(out + i), sum);
+            }
+        }
+
+        __attribute__((target("sse4.1")))
+        void clippedRelu16Sse41(const int16_t *in, uint8_t *out, int count)
+        {
+            const __m128i zero = _mm_setzero_si128();
+            for (int i = 0; i < count; i += 16) {
+                __m128i a = _mm_loadu_si128(reinterpret_cast<const __m128i *>(in + i));
+                __m128i b = _mm_loadu_si128(reinterpret_cast<const __m128i *>(in + i + 8));
+                _mm_storeu_si128(reinterpret_cast<__m128i *>(out + i), _mm_max_epi8(_mm_packs_epi16(a, b), zero));
+            }
+        }
+
+        __attribute__((target("sse4.1")))
+        void affineSse41(const uint8_t *in, int inputCount, const int8_t *weights, const int32_t *biases,
+                         int32_t *out, int outputCount)
+        {
+            const __m128i ones = _mm_set1_epi16(1);
+            for (int o = 0; o < outputCount; o++) {
+                const int8_t *row = weights + o * inputCount;
+                __m128i total = _mm_setzero_si128();
+                for (int i = 0; i < inputCount; i += 16) {
+                    __m128i x = _mm_loadu_si128(reinterpret_cast<const __m128i *>(in + i));
+                    __m128i w = _mm_loadu_si128(reinterpret_cast<const __m128i *>(row + i));
+                    total = _mm_add_epi32(total, _mm_madd_epi16(_mm_maddubs_epi16(x, w), ones));
+                }
+                total = _mm_add_epi32(total, _mm_shuffle_epi32(total, _MM_SHUFFLE(1, 0, 3, 2)));
+                total = _mm_add_epi32(total, _mm_shuffle_epi32(total, _MM_SHUFFLE(2, 3, 0, 1)));
+                out[o] = biases[o] + _mm_cvtsi128_si32(total);
+            }
+        }
+#endif
+
+        const Kernels ScalarKernels = { "scalar", accumulateScalar, clippedRelu16Scalar, affineScalar };
+#if defined(NNUE_X86_KERNELS)
+        const Kernels Avx2Kernels = { "avx2", accumulateAvx2, clippedRelu16Avx2, affineAvx2 };
+        const Kernels Sse41Kernels = { "sse4.1", accumulateSse41, clippedRelu16Sse41, affineSse41 };
+#endif
+
+        // the widest kernels this CPU runs
+        const Kernels *bestKernels()
+        {
+#if defined(NNUE_X86_KERNELS)
+            __builtin_cpu_init();
+            if (__builtin_cpu_supports("avx2")) {
+                return &Avx2Kernels;
+            }
+            if (__builtin_cpu_supports("sse4.1")) {
+                return &Sse41Kernels;
+            }
+#endif
+            return &ScalarKernels;
+        }
+
+        void clippedRelu32(const int32_t *in, uint8_t *out, int count)
+        {
+            for (int i = 0; i < count; i++) {
+                out[i] = static_cast<uint8_t>(std::clamp(in[i] >> WeightShift, 0, 127));
+            }
+        }
+
+        bool kingMoved(const DirtyPieces &dirty, int color)
+        {
+            for (int i = 0; i < dirty.count; i++) {
+                if (dirty.code[i] == makePieceCode(color, King)) {
+                    return true;
+                }
+            }
+            return false;
+        }
+
+        template <typename T>
+        bool readArray(std::ifstream &file, T *values, size_t count)
+        {
+            return static_cast<bool>(file.read(reinterpret_cast<char *>(values), count * sizeof(T)));
+        }
+    }
+
+    int featureIndex(int perspective, int kingSquare, int code, int square)
+    {
+        // each side sees the board from its own end, so black's squares are flipped rank-wise
+        int orient = perspective == White ? 0 : 56;
+        int piece = (pieceTypeOf(code) - 1) * 2 + (pieceColorOf(code) != perspective ? 1 : 0);
+        return ((kingSquare ^ orient) * 10 + piece) * 64 + (square ^ orient);
+    }
+
+    DirtyPieces dirtyPieces(const ChessPosition &position, ChessMove move)
+    {
+        DirtyPieces dirty;
+        auto add = [&dirty](int code, int from, int to) {
+            dirty.code[dirty.count] = code;
+            dirty.from[dirty.count] = from;
+            dirty.to[dirty.count] = to;
+            dirty.count++;
+        };
+
+        int us = position.sideToMove();
+        int from = move.from();
+        int to = move.to();
+        int moving = position.movingPiece(move);
+
+        if (move.isCapture()) {
+            int capturedSquare = move.isEnPassant() ? to + (us == White ? -8 : 8) : to;
+            add(position.capturedPiece(move), capturedSquare, -1);
+        }
+        if (move.isPromotion()) {
+            add(moving, from, -1);
+            add(makePieceCode(us, move.promotionPiece()), -1, to);
+        } else {
+            add(moving, from, to);
+        }
+        if (move.isCastle()) {
+            bool kingside = move.flags() == MoveKingCastle;
+            add(makePieceCode(us, Rook), kingside ? to + 1 : to - 2, kingside ? to - 1 : to + 1);
+        }
+        return dirty;
+    }
+
+    Network::Network() = default;
+    Network::~Network() = default;
+
+    bool Network::load(const std::string &path)
+    {
+        std::ifstream file(path, std::ios::binary);
+        if (!file) {
+            return false;
+        }
+
+        char magic[4];
+        uint32_t header[5];
+        if (!file.read(magic, sizeof(magic)) || std::memcmp(magic, FileMagic, sizeof(magic)) != 0 ||
+            !readArray(file, header, 5)) {
+            return false;
+        }
+        if (header[0] != FileVersion || header[1] != Inputs || header[2] != L1 || header[3] != L2 || header[4] != L3) {
+            return false;
+        }
+
+        auto parameters = std::make_unique<Parameters>();
+        parameters->kernels = bestKernels();
+        bool complete = readArray(file, parameters->featureBiases, L1) &&
+                        readArray(file, parameters->featureWeights, static_cast<size_t>(Inputs) * L1) &&
+                        readArray(file, parameters->hidden1Biases, L2) &&
+                        readArray(file, parameters->hidden1Weights, L2 * 2 * L1) &&
+                        readArray(file, parameters->hidden2Biases, L3) &&
+                        readArray(file, parameters->hidden2Weights, L3 * L2) &&
+                        readArray(file, &parameters->outputBias, 1) &&
+                        readArray(file, parameters->outputWeights, L3);
+        // a longer file is some other format that happens to share the header
+        if (!complete || file.peek() != std::ifstream::traits_type::eof()) {
+            return false;
+        }
+        _parameters = std::move(parameters);
+        return true;
+    }
+
+    const char *Network::instructionSet() const
+    {
+        return _parameters->kernels->name;
+    }
+
+    void Network::refresh(const ChessPosition &position, int perspective, Accumulator &accumulator) const
+    {
+        const int16_t *rows[32];
+        int count = 0;
+        int king = position.kingSquare(perspective);
+        if (king >= 0) {
+            Bitboard pieces = position.occupied() & ~position.pieces(White, King) & ~position.pieces(Black, King);
+            while (pieces && count < 32) {
+                int square = popLsb(pieces);
+                int index = featureIndex(perspective, king, position.pieceAt(square), square);
+                rows[count++] = _parameters->featureWeights + static_cast<size_t>(index) * L1;
+            }
+        }
+        _parameters->kernels->accumulate(_parameters->featureBiases, accumulator.values[perspective], rows, count, nullptr, 0);
+    }
+
+    void Network::update(const Accumulator &parent, Accumulator &child, int perspective, int kingSquare,
+                         const DirtyPieces &dirty) const
+    {
+        const int16_t *added[3];
+        const int16_t *removed[3];
+        int addedCount = 0;
+        int removedCount = 0;
+        for (int i = 0; i < dirty.count; i++) {
+            if (pieceTypeOf(dirty.code[i]) == King) {
+                continue;
+            }
+            if (dirty.from[i] >= 0) {
+                int index = featureIndex(perspective, kingSquare, dirty.code[i], dirty.from[i]);
+                removed[removedCount++] = _parameters->featureWeights + static_cast<size_t>(index) * L1;
+            }
+            if (dirty.to[i] >= 0) {
+                int index = featureIndex(perspective, kingSquare, dirty.code[i], dirty.to[i]);
+                added[addedCount++] = _parameters->featureWeights + static_cast<size_t>(index) * L1;
+            }
+        }
+        _parameters->kernels->accumulate(parent.values[perspective], child.values[perspective], added, addedCount, removed, removedCount);
+    }
+
+    int Network::evaluate(const Accumulator &accumulator, int sideToMove) const
+    {
+        // the side to move's half goes first, so the network knows whose turn it is
+        const Kernels &kernels = *_parameters->kernels;
+        alignas(64) uint8_t input[2 * L1];
+        kernels.clippedRelu16(accumulator.values[sideToMove], input, L1);
+        kernels.clippedRelu16(accumulator.values[sideToMove ^ 1], input + L1, L1);
+
+        alignas(64) int32_t hidden1[L2];
+        alignas(64) uint8_t hidden1Out[L2];
+        kernels.affine(input, 2 * L1, _parameters->hidden1Weights, _parameters->hidden1Biases, hidden1, L2);
+        clippedRelu32(hidden1, hidden1Out, L2);
+
+        alignas(64) int32_t hidden2[L3];
+        alignas(64) uint8_t hidden2Out[L3];
+        kernels.affine(hidden1Out, L2, _parameters->hidden2Weights, _parameters->hidden2Biases, hidden2, L3);
+        clippedRelu32(hidden2, hidden2Out, L3);
+
+        int32_t output;
+        kernels.affine(hidden2Out, L3, _parameters->outputWeights, &_parameters->outputBias, &output, 1);
+        return std::clamp(output / OutputScale, -MaxScore, MaxScore);
+    }
+
+    int Network::evaluate(const ChessPosition &position) const
+    {
+        Accumulator accumulator;
+        refresh(position, White, accumulator);
+        refresh(position, Black, accumulator);
+        return evaluate(accumulator, position.sideToMove());
+    }
+
+    AccumulatorStack::AccumulatorStack()
+    {
+        _entries.resize(256);
+    }
+
+    void AccumulatorStack::reset(const Network *network, const ChessPosition &root)
+    {
+        _network = network;
+        _size = 1;
+        if (_network) {
+            _network->refresh(root, White, _entries[0].accumulator);
+            _network->refresh(root, Black, _entries[0].accumulator);
+            _entries[0].computed[White] = _entries[0].computed[Black] = true;
+        }
+    }
+
+    void AccumulatorStack::push(const ChessPosition &position, ChessMove move)
+    {
+        if (!_network) {
+            return;
+        }
+        if (_size == static_cast<int>(_entries.size())) {
+            _entries.emplace_back();
+        }
+        Entry &entry = _entries[_size++];
+        entry.dirty = dirtyPieces(position, move);
+        entry.computed[White] = entry.computed[Black] = false;
+    }
+
+    void AccumulatorStack::pushNull()
+    {
+        if (!_network) {
+            return;
+        }
+        if (_size == static_cast<int>(_entries.size())) {
+            _entries.emplace_back();
+        }
+        Entry &entry = _entries[_size++];
+        entry.dirty = DirtyPieces();
+        entry.computed[White] = entry.computed[Black] = false;
+    }
+
+    void AccumulatorStack::pop()
+    {
+        if (_network) {
+            _size--;
+        }
+    }
+
+    int AccumulatorStack::evaluate(const ChessPosition &position)
+    {
+        bringUpToDate(position, White);
+        bringUpToDate(position, Black);
+        return _network->evaluate(_entries[_size - 1].accumulator, position.sideToMove());
+    }
+
+    void AccumulatorStack::bringUpToDate(const ChessPosition &position, int perspective)
+    {
+        int top = _size - 1;
+        // walk back to the last accumulator this side has; if its king moved on the way
+        // every one of its inputs changed, and starting over from the position is cheaper
+        int base = top;
+        while (!_entries[base].computed[perspective]) {
+            if (base == 0 || kingMoved(_entries[base].dirty, perspective)) {
+                _network->refresh(position, perspective, _entries[top].accumulator);
+                _entries[top].computed[perspective] = true;
+                return;
+            }
+            base--;
+        }
+
+        int king = position.kingSquare(perspective);
+        for (int i = base + 1; i <= top; i++) {
+            _network->update(_entries[i - 1].accumulator, _entries[i].accumulator, perspective, king, _entries[i].dirty);
+            _entries[i].computed[perspective] = true;
+        }
+    }
+}
@@ -0,0 +1,113 @@
+#pragma once
+
+#include "ChessPosition.h"
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+//
+// optional NNUE evaluation: a HalfKP network (king square x piece x square inputs,
+// seen from each side) with a 256-wide int16 first layer per side, then 512 -> 32 -> 32 -> 1
+// in int8. Only a handful of first layer inputs change per move, so its output (the
+// accumulator) is updated from the parent's instead of being recomputed.
+//
+// The inner loops use AVX2 or SSE4.1 when the CPU has them, picked when the network is
+// loaded, and scalar code otherwise.
+//
+namespace Nnue
+{
+    inline constexpr int Inputs = 64 * 10 * 64;
+    inline constexpr int L1 = 256;
+    inline constexpr int L2 = 32;
+    inline constexpr int L3 = 32;
+
+    // network output units per centipawn
+    inline constexpr int OutputScale = 16;
+    // hidden layer sums are scaled down by 2^WeightShift before the clipped ReLU
+    inline constexpr int WeightShift = 6;
+    // scores are kept well inside the search's mate range
+    inline constexpr int MaxScore = 30000;
+
+    // first layer input for a non-king piece seen from one side, whose king is on kingSquare
+    int featureIndex(int perspective, int kingSquare, int code, int square);
+
+    // the pieces a move moves, removes or adds, worked out before the move is made.
+    // A -1 from square means the piece appears (promotion), a -1 to square that it leaves the board.
+    struct DirtyPieces
+    {
+        int count = 0;
+        int code[3];
+        int from[3];
+        int to[3];
+    };
+    DirtyPieces dirtyPieces(const ChessPosition &position, ChessMove move);
+
+    // first layer output for each side
+    struct alignas(64) Accumulator
+    {
+        int16_t values[2][L1];
+    };
+
+    class Network
+    {
+    public:
+        Network();
+        ~Network();
+
+        // reads a network file (see readme for the layout); false leaves the network unchanged.
+        // Nothing else may be called before a load has succeeded.
+        bool load(const std::string &path);
+
+        void refresh(const ChessPosition &position, int perspective, Accumulator &accumulator) const;
+        // child = parent with the move's changes applied, for a side whose king didn't move
+        void update(const Accumulator &parent, Accumulator &child, int perspective, int kingSquare,
+                    const DirtyPieces &dirty) const;
+
+        // the instruction set the loaded network runs on: "avx2", "sse4.1" or "scalar"
+        const char *instructionSet() const;
+
+        // score in centipawns from the side to move's point of view
+        int evaluate(const Accumulator &accumulator, int sideToMove) const;
+        // the same, building the accumulator from scratch
+        int evaluate(const ChessPosition &position) const;
+
+    private:
+        struct Parameters;
+        std::unique_ptr<Parameters> _parameters;
+    };
+
+    //
+    // accumulators along the line a search thread is on. The search pushes before each
+    // makeMove and pops after unmakeMove; accumulators are only brought up to date
+    // when a position is evaluated, so lines cut off before a leaf cost nothing.
+    //
+    class AccumulatorStack
+    {
+    public:
+        AccumulatorStack();
+
+        // start over at the root; a null network turns every call into a no-op
+        void reset(const Network *network, const ChessPosition &root);
+        void push(const ChessPosition &position, ChessMove move);
+        void pushNull();
+        void pop();
+
+        // score of the position on top of the stack, from the side to move's point of view
+        int evaluate(const ChessPosition &position);
+
+    private:
+        struct Entry
+        {
+            Accumulator accumulator;
+            DirtyPieces dirty;
+            bool computed[2];
+        };
+
+        void bringUpToDate(const ChessPosition &position, int perspective);
+
+        const Network *_network = nullptr;
+        std::vector<Entry> _entries;
+        int _size = 0;
+    };
+}
@@ -0,0 +1,20 @@
+#include "PawnTable.h"
+#include <bit>
+
+PawnTable::PawnTable(int entries)
+{
+    size_t count = std::bit_floor(static_cast<size_t>(entries > 0 ? entries : 1));
+    _entries = std::make_unique<PawnEntry[]>(count);
+    _mask = count - 1;
+    clear();
+}
+
+void PawnTable::clear()
+{
+    // key 0 (no pawns at all) legitimately scores zero, so zeroed entries are valid for it
+    for (uint64_t i = 0; i <= _mask; i++) {
+        _entries[i] = PawnEntry{};
+        _entries[i].shieldKing[0] = _entries[i].shieldKing[1] = -1;
+    }
+    resetStats();
+}
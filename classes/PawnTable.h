@@ -0,0 +1,54 @@
+#pragma once
+
+#include "Bitboard.h"
+#include <cstdint>
+#include <memory>
+
+// cached evaluation of one pawn structure
+struct PawnEntry
+{
+    uint64_t key;
+    Bitboard passed[2];     // passed pawns by color
+    int16_t mg;             // doubled, isolated and passed pawn terms, from white's point of view
+    int16_t eg;
+    // pawn shield in front of each king, worked out for the king square it was last asked for
+    int8_t shieldKing[2];
+    int16_t shield[2];
+};
+
+//
+// pawn structure hash table, indexed by ChessPosition::pawnKey. Pawns move far less
+// often than the other pieces, so almost every evaluation finds its structure here.
+// Each search thread owns one, so entries are plain data with no locking.
+//
+class PawnTable
+{
+public:
+    static constexpr int DefaultEntries = 1 << 14;
+
+    // rounded down to a power of two
+    explicit PawnTable(int entries = DefaultEntries);
+
+    void clear();
+
+    // the slot for a key; hit tells whether it already holds that structure,
+    // otherwise the caller fills it in
+    PawnEntry &probe(uint64_t key, bool &hit)
+    {
+        PawnEntry &entry = _entries[key & _mask];
+        hit = entry.key == key;
+        _probes++;
+        _hits += hit ? 1 : 0;
+        return entry;
+    }
+
+    uint64_t probes() const { return _probes; }
+    uint64_t hits() const { return _hits; }
+    void resetStats() { _probes = _hits = 0; }
+
+private:
+    std::unique_ptr<PawnEntry[]> _entries;
+    uint64_t _mask = 0;
+    uint64_t _probes = 0;
+    uint64_t _hits = 0;
+};
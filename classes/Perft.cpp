@@ -0,0 +1,62 @@
+#include "Perft.h"
+#include <chrono>
+
+const PerftCase PerftSuite[] = {
+    { "startpos",   "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1",                 5, 4865609 },
+    { "kiwipete",   "r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - 0 1",     4, 4085603 },
+    { "position3",  "8/2p5/3p4/KP5r/1R3p1k/8/4P1P1/8 w - - 0 1",                                6, 11030083 },
+    { "position4",  "r3k2r/Pppp1ppp/1b3nbN/nP6/BBP1P3/q4N2/Pp1P2PP/R2Q1RK1 w kq - 0 1",         5, 15833292 },
+    { "position4m", "r2q1rk1/pP1p2pp/Q4n2/bbp1p3/Np6/1B3NBn/pPPP1PPP/R3K2R b KQ - 0 1",         5, 15833292 },
+    { "position5",  "rnbq1k1r/pp1Pbppp/2p5/8/2B5/8/PPP1NnPP/RNBQK2R w KQ - 1 8",                4, 2103487 },
+    { "position6",  "r4rk1/1pp1qppp/p1np1n2/2b1p1B1/2B1P1b1/P1NP1N2/1PP1QPPP/R4RK1 w - - 0 10", 4, 3894594 },
+};
+const int PerftSuiteSize = sizeof(PerftSuite) / sizeof(PerftSuite[0]);
+
+uint64_t perft(ChessPosition &position, int depth)
+{
+    if (depth == 0) {
+        return 1;
+    }
+
+    MoveList moves;
+    position.generateLegalMoves(moves);
+
+    // the generator is fully legal, so the last ply is just a count
+    if (depth == 1) {
+        return moves.size();
+    }
+
+    uint64_t nodes = 0;
+    for (const auto &move : moves) {
+        position.makeMove(move);
+        nodes += perft(position, depth - 1);
+        position.unmakeMove();
+    }
+    return nodes;
+}
+
+PerftResult timedPerft(ChessPosition &position, int depth)
+{
+    auto start = std::chrono::steady_clock::now();
+    PerftResult result;
+    result.nodes = perft(position, depth);
+    result.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    return result;
+}
+
+std::vector<std::pair<ChessMove, uint64_t>> perftDivide(ChessPosition &position, int depth)
+{
+    std::vector<std::pair<ChessMove, uint64_t>> counts;
+    if (depth < 1) {
+        return counts;
+    }
+
+    MoveList moves;
+    position.generateLegalMoves(moves);
+    for (const auto &move : moves) {
+        position.makeMove(move);
+        counts.push_back({move, perft(position, depth - 1)});
+        position.unmakeMove();
+    }
+    return counts;
+}
@@ -0,0 +1,37 @@
+#pragma once
+
+#include "ChessPosition.h"
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+//
+// perft counts the leaf nodes of the legal move tree to a fixed depth.
+// The counts are known for standard positions, so it is both the move
+// generator's correctness check and its throughput benchmark.
+//
+struct PerftResult
+{
+    uint64_t nodes = 0;
+    double seconds = 0.0;
+
+    uint64_t nodesPerSecond() const { return seconds > 0.0 ? static_cast<uint64_t>(nodes / seconds) : 0; }
+};
+
+struct PerftCase
+{
+    const char *name;
+    const char *fen;
+    int depth;
+    uint64_t nodes;
+};
+
+// standard positions with their published node counts
+extern const PerftCase PerftSuite[];
+extern const int PerftSuiteSize;
+
+// the position is walked with make/unmake and is unchanged on return
+uint64_t perft(ChessPosition &position, int depth);
+PerftResult timedPerft(ChessPosition &position, int depth);
+// node count below each root move, in generation order
+std::vector<std::pair<ChessMove, uint64_t>> perftDivide(ChessPosition &position, int depth);
@@ -0,0 +1,479 @@
+#include "SearchWorker.h"
+#include "Bitbase.h"
+#include "Evaluation.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <utility>
+
+namespace
+{
+    // helper thread depth skipping, cycled by thread: thread i skips a depth when
+    // ((depth + SkipPhase[i]) / SkipSize[i]) is odd, so about half the helpers
+    // work one iteration ahead of the rest
+    const int SkipSize[] = { 1, 1, 2, 2, 2, 2, 3, 3, 3, 3, 3, 3, 4, 4, 4, 4, 4, 4, 4, 4 };
+    const int SkipPhase[] = { 0, 1, 0, 1, 2, 3, 0, 1, 2, 3, 4, 5, 0, 1, 2, 3, 4, 5, 6, 7 };
+
+    // a capture that can't lift the score to within this of alpha isn't searched in quiescence
+    const int DeltaMargin = 200;
+
+    // late move reductions by [depth][move number]: log(depth) * log(moveNumber) / 2.25 + 0.75,
+    // so late moves at deep nodes lose the most
+    struct ReductionTable
+    {
+        int values[64][64];
+
+        ReductionTable()
+        {
+            for (int depth = 0; depth < 64; depth++) {
+                for (int moveNumber = 0; moveNumber < 64; moveNumber++) {
+                    values[depth][moveNumber] = depth && moveNumber
+                        ? static_cast<int>(0.75 + std::log(depth) * std::log(moveNumber) / 2.25)
+                        : 0;
+                }
+            }
+        }
+    };
+    const ReductionTable Reductions;
+
+    int lateMoveReduction(int depth, int moveNumber)
+    {
+        return Reductions.values[std::min(depth, 63)][std::min(moveNumber, 63)];
+    }
+}
+
+SearchWorker::SearchWorker(ChessSearch& search, int index)
+    : _search(search), _index(index)
+{
+}
+
+void SearchWorker::start(const ChessPosition& root, const MoveList& rootMoves, unsigned seed)
+{
+    _position = root;
+    _accumulators.reset(_search._network.get(), _position);
+    _random.seed(seed);
+    _nodes = 0;
+    _publishedNodes.store(0, std::memory_order_relaxed);
+    _result = SearchResult();
+
+    for (auto& killers : _killers) {
+        killers[0] = killers[1] = ChessMove();
+    }
+    // Keep what history learned last move, but let this search outweigh it
+    for (auto& side : _history) {
+        for (auto& from : side) {
+            for (int& entry : from) {
+                entry /= 2;
+            }
+        }
+    }
+
+    // Shuffle the root so equal moves don't always resolve the same way,
+    // and so each thread breaks ties differently
+    _rootMoves.clear();
+    for (ChessMove move : rootMoves) {
+        _rootMoves.push_back({ move, 0, 0 });
+    }
+    for (int i = static_cast<int>(_rootMoves.size()) - 1; i > 0; i--) {
+        std::swap(_rootMoves[i], _rootMoves[_random() % (i + 1)]);
+    }
+}
+
+bool SearchWorker::stopped() const
+{
+    return _search.stopped();
+}
+
+int SearchWorker::evaluate()
+{
+    int score;
+    _evalStats.probes++;
+    if (_search._evalCache.probe(_position.key(), score)) {
+        _evalStats.hits++;
+        return score;
+    }
+    if (_search._network) {
+        score = _accumulators.evaluate(_position);
+    } else {
+        score = Eval::evaluate(_position, &_pawnTable);
+        score = _position.sideToMove() == White ? score : -score;
+    }
+    _search._evalCache.store(_position.key(), score);
+    return score;
+}
+
+void SearchWorker::makeMove(ChessMove move)
+{
+    _accumulators.push(_position, move);
+    _position.makeMove(move);
+}
+
+void SearchWorker::unmakeMove()
+{
+    _position.unmakeMove();
+    _accumulators.pop();
+}
+
+void SearchWorker::makeNullMove()
+{
+    _accumulators.pushNull();
+    _position.makeNullMove();
+}
+
+void SearchWorker::unmakeNullMove()
+{
+    _position.unmakeNullMove();
+    _accumulators.pop();
+}
+
+void SearchWorker::pollLimits()
+{
+    _publishedNodes.store(_nodes, std::memory_order_relaxed);
+    _search.checkLimits();
+}
+
+bool SearchWorker::skipDepth(int depth) const
+{
+    if (_index == 0) {
+        return false;
+    }
+    int i = (_index - 1) % 20;
+    return ((depth + SkipPhase[i]) / SkipSize[i]) % 2 != 0;
+}
+
+void SearchWorker::storeKiller(int ply, ChessMove move)
+{
+    if (_killers[ply][0] != move) {
+        _killers[ply][1] = _killers[ply][0];
+        _killers[ply][0] = move;
+    }
+}
+
+// bonus for the cutoff move and the same malus for the quiets tried before it.
+// Gravity scales each update by how far the entry is from the limit, keeping it in range.
+void SearchWorker::updateHistory(int color, ChessMove cutoffMove, int depth, const MoveList& quietsTried)
+{
+    int bonus = std::min(depth * depth, HistoryMax / 4);
+    auto update = [&](ChessMove move, int delta) {
+        int& entry = _history[color][move.from()][move.to()];
+        entry += delta - entry * std::abs(delta) / HistoryMax;
+    };
+    update(cutoffMove, bonus);
+    for (ChessMove move : quietsTried) {
+        update(move, -bonus);
+    }
+}
+
+// Negamax with Alpha-Beta Pruning
+int SearchWorker::negamax(int depth, int ply, int alpha, int beta, bool allowNull)
+{
+    if ((++_nodes & 2047) == 0) {
+        pollLimits();
+    }
+    if (stopped()) {
+        return 0; // Result is thrown away
+    }
+    // Covered endings are looked up rather than searched. A mate too far from the root to
+    // count in plies still scores past MateBound, so the table adjusts it by ply like any other
+    Bitbase::ProbeResult known;
+    if (popCount(_position.occupied()) <= Bitbase::MaxPieces && Bitbase::probe(_position, known)) {
+        return known.wdl * std::max(ChessSearch::MateScore - ply - known.plies, ChessSearch::MateBound + 1);
+    }
+    if (depth == 0 || ply >= ChessSearch::MaxPly) {
+        return quiescence(ply, alpha, beta);
+    }
+
+    // A deep enough stored result settles the node without searching it
+    int originalAlpha = alpha;
+    TTData entry;
+    ChessMove ttMove;
+    if (_search._tt.probe(_position.key(), entry, _ttStats)) {
+        ttMove = entry.move;
+        int score = ChessSearch::scoreFromTT(entry.score, ply);
+        if (entry.depth >= depth &&
+            (entry.bound == BoundExact ||
+             (entry.bound == BoundLower && score >= beta) ||
+             (entry.bound == BoundUpper && score <= alpha))) {
+            return score;
+        }
+    }
+
+    bool pvNode = beta - alpha > 1;
+    bool inCheck = _position.inCheck();
+
+    // Null-move pruning: if passing still leaves us at or above beta after a reduced
+    // search, a real move surely would too. Not with only pawns left, where having to
+    // move can be the whole problem (zugzwang), and never twice in a row.
+    if (allowNull && !pvNode && !inCheck && depth >= NullMoveMinDepth &&
+        _position.hasNonPawnMaterial(_position.sideToMove()) &&
+        evaluate() >= beta) {
+        int reduction = 2 + depth / 4;
+        makeNullMove();
+        int score = -negamax(std::max(depth - 1 - reduction, 0), ply + 1, -beta, -beta + 1, false);
+        unmakeNullMove();
+        if (stopped()) {
+            return 0;
+        }
+        if (score >= beta) {
+            // a mate found after passing isn't proven, so don't report it
+            return score > ChessSearch::MateBound ? beta : score;
+        }
+    }
+
+    // Moves come lazily in stages, so a cutoff skips generating the rest
+    MovePicker picker(_position, ttMove, _killers[ply], &_history);
+    int maxScore = -ChessSearch::Infinity;
+    ChessMove bestMove;
+    int moveCount = 0;
+    MoveList quietsTried;
+
+    for (ChessMove move = picker.next(); !move.isNull(); move = picker.next()) {
+        bool quiet = !move.isCapture() && !move.isPromotion();
+
+        // Near the horizon, skip quiet moves that just put a piece where it can be taken for nothing
+        if (!pvNode && !inCheck && quiet && moveCount > 0 && depth <= SeePruneDepth &&
+            maxScore > -ChessSearch::MateBound && _position.staticExchange(move) < -SeeQuietMargin * depth) {
+            continue;
+        }
+
+        moveCount++;
+        makeMove(move);
+        int score;
+        if (moveCount == 1) {
+            score = -negamax(depth - 1, ply + 1, -beta, -alpha);
+        } else {
+            // LMR: quiet moves ordered this late rarely matter, so search them shallower
+            // first. Checks, evasions and moves that beat alpha get the full depth.
+            int reduction = 0;
+            if (depth >= LmrMinDepth && moveCount > LmrMinMoves && quiet && !inCheck && !_position.inCheck()) {
+                reduction = lateMoveReduction(depth, moveCount) - (pvNode ? 1 : 0);
+                reduction = std::clamp(reduction, 0, depth - 2);
+            }
+
+            // PVS: with good ordering the first move is best, so the rest only need proving
+            // worse with a zero window. One that beats alpha is searched again in full.
+            score = -negamax(depth - 1 - reduction, ply + 1, -alpha - 1, -alpha);
+            if (reduction && score > alpha) {
+                score = -negamax(depth - 1, ply + 1, -alpha - 1, -alpha);
+            }
+            if (score > alpha && score < beta) {
+                score = -negamax(depth - 1, ply + 1, -beta, -alpha);
+            }
+        }
+        unmakeMove();
+        if (stopped()) {
+            return 0; // Unfinished, so nothing goes in the table
+        }
+
+        if (score > maxScore) {
+            maxScore = score;
+            bestMove = move;
+        }
+        alpha = std::max(alpha, score);
+
+        if (alpha >= beta) {
+            // Quiet moves that refute a line are likely to refute its siblings too
+            if (quiet) {
+                storeKiller(ply, move);
+                updateHistory(_position.sideToMove(), move, depth, quietsTried);
+            }
+            break; // Beta cutoff
+        }
+        if (quiet) {
+            quietsTried.push_back(move);
+        }
+    }
+
+    // Check for game over
+    if (moveCount == 0) {
+        if (inCheck) {
+            return -ChessSearch::MateScore + ply; // Checkmate, sooner is worse
+        }
+        return 0; // Stalemate
+    }
+
+    int bound = maxScore >= beta ? BoundLower : maxScore > originalAlpha ? BoundExact : BoundUpper;
+    _search._tt.store(_position.key(), depth, ChessSearch::scoreToTT(maxScore, ply), bound, bestMove, _ttStats);
+    return maxScore;
+}
+
+int SearchWorker::quiescence(int ply, int alpha, int beta)
+{
+    if ((++_nodes & 2047) == 0) {
+        pollLimits();
+    }
+    if (stopped()) {
+        return 0;
+    }
+
+    // In check every evasion is searched and standing pat isn't an option
+    bool inCheck = _position.inCheck();
+    int standPat = evaluate();
+    if (ply >= ChessSearch::MaxPly) {
+        return standPat;
+    }
+
+    int bestScore = -ChessSearch::Infinity;
+    if (!inCheck) {
+        // Stand pat: the side to move can decline every capture
+        if (standPat >= beta) {
+            return standPat;
+        }
+        alpha = std::max(alpha, standPat);
+        bestScore = standPat;
+    }
+
+    static const ChessMove noKillers[2];
+    MovePicker picker = inCheck ? MovePicker(_position, ChessMove(), noKillers) : MovePicker(_position);
+    int moveCount = 0;
+
+    for (ChessMove move = picker.next(); !move.isNull(); move = picker.next()) {
+        moveCount++;
+
+        // Delta pruning: skip captures that can't get back to alpha even winning the piece for free.
+        // Captures that lose material by static exchange are skipped outright.
+        if (!inCheck) {
+            int gain = PieceValues[pieceTypeOf(_position.capturedPiece(move))];
+            if (move.isPromotion()) {
+                gain += PieceValues[move.promotionPiece()] - PieceValues[Pawn];
+            }
+            if (standPat + gain + DeltaMargin <= alpha || _position.staticExchange(move) < 0) {
+                continue;
+            }
+        }
+
+        makeMove(move);
+        int score = -quiescence(ply + 1, -beta, -alpha);
+        unmakeMove();
+        if (stopped()) {
+            return 0;
+        }
+
+        if (score > bestScore) {
+            bestScore = score;
+            if (score > alpha) {
+                alpha = score;
+                if (alpha >= beta) {
+                    break;
+                }
+            }
+        }
+    }
+
+    if (inCheck && moveCount == 0) {
+        return -ChessSearch::MateScore + ply; // Checkmate
+    }
+    return bestScore;
+}
+
+// Search every root move in order, recording each one's score and subtree size.
+// Returns a bound like negamax: at most alpha on a fail low, at least beta on a fail high.
+int SearchWorker::searchRoot(int depth, int alpha, int beta)
+{
+    int originalAlpha = alpha;
+    int bestScore = -ChessSearch::Infinity;
+    int bestIndex = 0;
+
+    for (int i = 0; i < static_cast<int>(_rootMoves.size()); i++) {
+        RootMove& root = _rootMoves[i];
+        uint64_t nodesBefore = _nodes;
+        makeMove(root.move);
+        int score;
+        if (i == 0) {
+            score = -negamax(depth - 1, 1, -beta, -alpha);
+        } else {
+            score = -negamax(depth - 1, 1, -alpha - 1, -alpha);
+            if (score > alpha && score < beta) {
+                score = -negamax(depth - 1, 1, -beta, -alpha);
+            }
+        }
+        unmakeMove();
+        if (stopped()) {
+            break;
+        }
+        root.score = score;
+        root.nodes = _nodes - nodesBefore;
+
+        if (score > bestScore) {
+            bestScore = score;
+            bestIndex = i;
+        }
+        alpha = std::max(alpha, score);
+        if (alpha >= beta) {
+            break;
+        }
+    }
+
+    // After a fail low every score is only an upper bound, so the order is left alone
+    if (!stopped() && bestScore > originalAlpha) {
+        // Next iteration: the best move first, then the rest by how much effort it took
+        // to refute them, since a move that was hard to refute is more likely to take over
+        std::swap(_rootMoves[0], _rootMoves[bestIndex]);
+        std::stable_sort(_rootMoves.begin() + 1, _rootMoves.end(), [](const RootMove& a, const RootMove& b) {
+            return a.nodes > b.nodes;
+        });
+    }
+    return bestScore;
+}
+
+void SearchWorker::iterate()
+{
+    // Order the root by a quiescence score before the first iteration
+    for (RootMove& root : _rootMoves) {
+        makeMove(root.move);
+        root.score = -quiescence(1, -ChessSearch::Infinity, ChessSearch::Infinity);
+        unmakeMove();
+    }
+    std::stable_sort(_rootMoves.begin(), _rootMoves.end(), [](const RootMove& a, const RootMove& b) {
+        return a.score > b.score;
+    });
+    _result.bestMove = _rootMoves[0].move;
+
+    int maxDepth = _search.maxDepth();
+    for (int depth = 1; depth <= maxDepth && !stopped(); depth++) {
+        if (depth > 1 && skipDepth(depth)) {
+            continue;
+        }
+
+        // Aspiration window: expect a score near the last iteration's, and widen
+        // the failing side exponentially until the true score falls inside
+        int delta = AspirationWindow;
+        int alpha = -ChessSearch::Infinity;
+        int beta = ChessSearch::Infinity;
+        if (depth >= AspirationMinDepth && std::abs(_result.score) < ChessSearch::MateBound) {
+            alpha = std::max(_result.score - delta, -ChessSearch::Infinity);
+            beta = std::min(_result.score + delta, ChessSearch::Infinity);
+        }
+
+        int score;
+        while (true) {
+            score = searchRoot(depth, alpha, beta);
+            if (stopped()) {
+                break;
+            }
+            if (score <= alpha) {
+                beta = (alpha + beta) / 2;
+                alpha = std::max(score - delta, -ChessSearch::Infinity);
+            } else if (score >= beta) {
+                beta = std::min(score + delta, ChessSearch::Infinity);
+            } else {
+                break;
+            }
+            delta *= 2;
+        }
+        if (stopped()) {
+            break; // Unfinished iteration, keep the last complete one
+        }
+
+        _result.bestMove = _rootMoves[0].move;
+        _result.score = score;
+        _result.depth = depth;
+
+        // A forced mate won't get any shorter by looking deeper
+        if (std::abs(score) > ChessSearch::MateBound) {
+            break;
+        }
+        pollLimits();
+    }
+    _publishedNodes.store(_nodes, std::memory_order_relaxed);
+}
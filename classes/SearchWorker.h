@@ -0,0 +1,96 @@
+#pragma once
+
+#include "ChessSearch.h"
+#include "MovePicker.h"
+#include "Nnue.h"
+#include "PawnTable.h"
+#include <atomic>
+#include <cstdint>
+#include <random>
+#include <vector>
+
+//
+// one search thread's state: its own copy of the position plus the move ordering
+// tables (killers, history, root order), which stay thread local. Everything the
+// threads share - transposition table, limits, stop flag - lives in ChessSearch.
+//
+class SearchWorker
+{
+public:
+    SearchWorker(ChessSearch &search, int index);
+
+    // prepare for a new search; called on the thread that owns the ChessSearch
+    void start(const ChessPosition &root, const MoveList &rootMoves, unsigned seed);
+    // iterative deepening until the search is stopped or the depth limit is reached
+    void iterate();
+
+    // the deepest iteration this worker completed
+    const SearchResult &result() const { return _result; }
+    // node count as of the last limit check, readable from other threads
+    uint64_t nodes() const { return _publishedNodes.load(std::memory_order_relaxed); }
+    // this thread's transposition table and eval cache traffic since the hash was last
+    // cleared; read between searches
+    const TTStats &ttStats() const { return _ttStats; }
+    const EvalCacheStats &evalStats() const { return _evalStats; }
+    void resetStats()
+    {
+        _ttStats = TTStats();
+        _evalStats = EvalCacheStats();
+    }
+
+private:
+    struct RootMove
+    {
+        ChessMove move;
+        int score;
+        uint64_t nodes;     // size of its subtree in the last iteration
+    };
+
+    int searchRoot(int depth, int alpha, int beta);
+    int negamax(int depth, int ply, int alpha, int beta, bool allowNull = true);
+    // captures only past the horizon, so the static eval is never taken mid-exchange
+    int quiescence(int ply, int alpha, int beta);
+    // static score for the side to move, through the shared eval cache: the network when
+    // one is loaded, otherwise the hand written evaluation through this thread's pawn table
+    int evaluate();
+    // walk the position, with the network's accumulators following along
+    void makeMove(ChessMove move);
+    void unmakeMove();
+    void makeNullMove();
+    void unmakeNullMove();
+    // called every few thousand nodes
+    void pollLimits();
+    bool stopped() const;
+    // helper threads skip some depths so the threads spread over several iterations
+    bool skipDepth(int depth) const;
+
+    void storeKiller(int ply, ChessMove move);
+    void updateHistory(int color, ChessMove cutoffMove, int depth, const MoveList &quietsTried);
+
+    static constexpr int HistoryMax = 16384;
+    static constexpr int AspirationWindow = 25;
+    static constexpr int AspirationMinDepth = 4;
+    static constexpr int NullMoveMinDepth = 3;
+    static constexpr int LmrMinDepth = 3;
+    static constexpr int LmrMinMoves = 3;
+    static constexpr int SeePruneDepth = 3;
+    static constexpr int SeeQuietMargin = 60;
+
+    ChessSearch &_search;
+    int _index;     // 0 is the main thread
+    ChessPosition _position;
+    std::vector<RootMove> _rootMoves;
+    std::minstd_rand _random;
+
+    // two quiet moves per ply that last caused a beta cutoff, newest first
+    ChessMove _killers[ChessSearch::MaxPly][2];
+    ButterflyHistory _history = {};
+    PawnTable _pawnTable;
+    Nnue::AccumulatorStack _accumulators;
+
+    uint64_t _nodes = 0;
+    std::atomic<uint64_t> _publishedNodes{0};
+    TTStats _ttStats;
+    EvalCacheStats _evalStats;
+    SearchResult _result;
+};
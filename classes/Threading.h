@@ -0,0 +1,23 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <thread>
+#include <vector>
+
+// run count items over the given number of threads, in contiguous slices:
+// function(thread, begin, end) is called once per thread and returns when all have finished
+template <typename Function>
+void parallelFor(int threads, size_t count, Function function)
+{
+    std::vector<std::thread> workers;
+    size_t slice = (count + threads - 1) / threads;
+    for (int t = 0; t < threads; t++) {
+        size_t begin = std::min(count, t * slice);
+        size_t end = std::min(count, begin + slice);
+        workers.emplace_back([&function, t, begin, end] { function(t, begin, end); });
+    }
+    for (auto &worker : workers) {
+        worker.join();
+    }
+}
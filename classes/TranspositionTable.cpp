@@ -0,0 +1,116 @@
+#include "TranspositionTable.h"
+#include <algorithm>
+
+TranspositionTable::TranspositionTable(size_t sizeMB)
+{
+    resize(sizeMB);
+}
+
+void TranspositionTable::resize(size_t sizeMB)
+{
+    size_t bytes = std::max<size_t>(sizeMB, 1) << 20;
+    size_t count = 1;
+    while (count * 2 * sizeof(Bucket) <= bytes) {
+        count *= 2;
+    }
+    _buckets.reset(new Bucket[count]);
+    _bucketCount = count;
+    clear();
+}
+
+void TranspositionTable::clear()
+{
+    for (size_t i = 0; i < _bucketCount; i++) {
+        for (auto &entry : _buckets[i].entries) {
+            entry.keyXorData.store(0, std::memory_order_relaxed);
+            entry.data.store(0, std::memory_order_relaxed);
+        }
+    }
+    _age = 0;
+}
+
+uint64_t TranspositionTable::pack(ChessMove move, int score, int depth, int bound, unsigned age)
+{
+    return static_cast<uint64_t>(move.raw()) |
+           (static_cast<uint64_t>(static_cast<uint32_t>(score)) << 16) |
+           (static_cast<uint64_t>(static_cast<uint8_t>(depth)) << 48) |
+           (static_cast<uint64_t>(bound & 3) << 56) |
+           (static_cast<uint64_t>(age & AgeMask) << 58);
+}
+
+bool TranspositionTable::probe(uint64_t key, TTData &result, TTStats &stats)
+{
+    stats.probes++;
+    Bucket &bucket = bucketFor(key);
+    for (auto &entry : bucket.entries) {
+        uint64_t data = entry.data.load(std::memory_order_relaxed);
+        if ((entry.keyXorData.load(std::memory_order_relaxed) ^ data) != key || boundOf(data) == BoundNone) {
+            continue;
+        }
+        result.move = ChessMove::fromRaw(static_cast<uint16_t>(data));
+        result.score = static_cast<int32_t>(static_cast<uint32_t>(data >> 16));
+        result.depth = depthOf(data);
+        result.bound = boundOf(data);
+        stats.hits++;
+        return true;
+    }
+    return false;
+}
+
+void TranspositionTable::store(uint64_t key, int depth, int score, int bound, ChessMove move, TTStats &stats)
+{
+    Bucket &bucket = bucketFor(key);
+
+    // reuse this position's entry if it has one, otherwise replace the least
+    // useful: shallowest, with entries from earlier searches counting as 8 plies shallower
+    Entry *replace = nullptr;
+    uint64_t replaceData = 0;
+    int worst = 0;
+    for (auto &entry : bucket.entries) {
+        uint64_t data = entry.data.load(std::memory_order_relaxed);
+        if ((entry.keyXorData.load(std::memory_order_relaxed) ^ data) == key || boundOf(data) == BoundNone) {
+            replace = &entry;
+            replaceData = data;
+            break;
+        }
+        unsigned age = (_age - ageOf(data)) & AgeMask;
+        int value = depthOf(data) - 8 * static_cast<int>(age);
+        if (!replace || value < worst) {
+            replace = &entry;
+            replaceData = data;
+            worst = value;
+        }
+    }
+
+    bool samePosition = (replace->keyXorData.load(std::memory_order_relaxed) ^ replaceData) == key;
+    if (samePosition) {
+        // keep the old move rather than lose it to a search that didn't find one, and don't
+        // let a shallow non-exact result from this search overwrite a deeper one
+        if (move.isNull()) {
+            move = ChessMove::fromRaw(static_cast<uint16_t>(replaceData));
+        }
+        if (bound != BoundExact && ageOf(replaceData) == _age && depth + 2 < depthOf(replaceData)) {
+            return;
+        }
+    } else if (boundOf(replaceData) != BoundNone) {
+        stats.collisions++;
+    }
+
+    uint64_t data = pack(move, score, depth, bound, _age);
+    replace->keyXorData.store(key ^ data, std::memory_order_relaxed);
+    replace->data.store(data, std::memory_order_relaxed);
+    stats.stores++;
+}
+
+int TranspositionTable::hashfull() const
+{
+    int used = 0;
+    size_t sample = std::min<size_t>(_bucketCount, 1000 / BucketSize);
+    for (size_t i = 0; i < sample; i++) {
+        for (const auto &entry : _buckets[i].entries) {
+            uint64_t data = entry.data.load(std::memory_order_relaxed);
+            used += boundOf(data) != BoundNone && ageOf(data) == _age;
+        }
+    }
+    return sample ? static_cast<int>(used * 1000 / (sample * BucketSize)) : 0;
+}
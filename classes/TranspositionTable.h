@@ -0,0 +1,91 @@
+#pragma once
+
+#include "ChessPosition.h"
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+
+enum TTBound
+{
+    BoundNone = 0,
+    BoundUpper = 1,     // score is at most this (failed low)
+    BoundLower = 2,     // score is at least this (failed high)
+    BoundExact = 3
+};
+
+// what a probe hands back, unpacked
+struct TTData
+{
+    ChessMove move;
+    int score;
+    int depth;
+    int bound;
+};
+
+// counted by each search thread on its own, so the threads don't contend on a shared line
+struct TTStats
+{
+    uint64_t probes = 0;
+    uint64_t hits = 0;
+    uint64_t stores = 0;
+    uint64_t collisions = 0;    // stores that evicted a different position's entry
+};
+
+//
+// fixed-size hash table of search results shared by every search thread without locks.
+// Entries are grouped four to a 64-byte bucket so a probe touches one cache line.
+// Each entry is two 64-bit words, the key XORed with the data and the data itself;
+// a torn write from two threads racing on an entry no longer XORs back to the key,
+// so it reads as a miss instead of corrupt data.
+//
+class TranspositionTable
+{
+public:
+    static constexpr int BucketSize = 4;
+    static constexpr size_t DefaultSizeMB = 16;
+
+    explicit TranspositionTable(size_t sizeMB = DefaultSizeMB);
+
+    // reallocates (and so clears) the table, rounded down to a power of two buckets
+    void resize(size_t sizeMB);
+    void clear();
+    size_t sizeMB() const { return (_bucketCount * sizeof(Bucket)) >> 20; }
+
+    // start of a new search; entries from older searches are replaced first
+    void newSearch() { _age = (_age + 1) & AgeMask; }
+
+    // both count into the caller's stats
+    bool probe(uint64_t key, TTData &data, TTStats &stats);
+    void store(uint64_t key, int depth, int score, int bound, ChessMove move, TTStats &stats);
+
+    // per mille of sampled entries written during the current search
+    int hashfull() const;
+
+private:
+    static constexpr unsigned AgeMask = 63;
+
+    struct Entry
+    {
+        std::atomic<uint64_t> keyXorData;
+        std::atomic<uint64_t> data;
+    };
+
+    struct alignas(64) Bucket
+    {
+        Entry entries[BucketSize];
+    };
+    static_assert(sizeof(Bucket) == 64, "a bucket must fill exactly one cache line");
+
+    // data layout: move 16 bits, score 32, depth 8, bound 2, age 6
+    static uint64_t pack(ChessMove move, int score, int depth, int bound, unsigned age);
+    static int depthOf(uint64_t data) { return static_cast<int8_t>(data >> 48); }
+    static int boundOf(uint64_t data) { return static_cast<int>((data >> 56) & 3); }
+    static unsigned ageOf(uint64_t data) { return static_cast<unsigned>(data >> 58); }
+
+    Bucket &bucketFor(uint64_t key) { return _buckets[key & (_bucketCount - 1)]; }
+
+    std::unique_ptr<Bucket[]> _buckets;
+    size_t _bucketCount = 0;
+    unsigned _age = 0;
+};
@@ -0,0 +1,52 @@
+#include "Zobrist.h"
+#include <mutex>
+
+namespace Zobrist
+{
+    uint64_t PieceSquare[16][64];
+    uint64_t Castling[16];
+    uint64_t EnPassantFile[8];
+    uint64_t SideToMove;
+
+    namespace
+    {
+        // splitmix64, fixed seed so keys (and anything stored by key) are the same on every run
+        uint64_t nextKey(uint64_t &state)
+        {
+            uint64_t z = (state += 0x9E3779B97F4A7C15ULL);
+            z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+            z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+            return z ^ (z >> 31);
+        }
+    }
+
+    void init()
+    {
+        static std::once_flag initialized;
+        std::call_once(initialized, [] {
+            uint64_t seed = 0x2545F4914F6CDD1DULL;
+            for (auto &squares : PieceSquare) {
+                for (auto &key : squares) {
+                    key = nextKey(seed);
+                }
+            }
+            // individual rights are XORed together so removing one right is a single update
+            uint64_t rightKeys[4];
+            for (auto &key : rightKeys) {
+                key = nextKey(seed);
+            }
+            for (int rights = 0; rights < 16; rights++) {
+                Castling[rights] = 0;
+                for (int bit = 0; bit < 4; bit++) {
+                    if (rights & (1 << bit)) {
+                        Castling[rights] ^= rightKeys[bit];
+                    }
+                }
+            }
+            for (auto &key : EnPassantFile) {
+                key = nextKey(seed);
+            }
+            SideToMove = nextKey(seed);
+        });
+    }
+}
@@ -0,0 +1,20 @@
+#pragma once
+
+#include <cstdint>
+
+//
+// random keys for Zobrist hashing: a position's key is the XOR of the keys of
+// everything in it, so a move updates it by XORing out what changed.
+// Zobrist::init() must be called once before the keys are used.
+//
+namespace Zobrist
+{
+    void init();
+
+    extern uint64_t PieceSquare[16][64];    // indexed by mailbox piece code
+    extern uint64_t Castling[16];           // indexed by the CastlingRight bit set
+    extern uint64_t EnPassantFile[8];
+    extern uint64_t SideToMove;             // XORed in when black is to move
+
+    inline uint64_t piece(int code, int square) { return PieceSquare[code][square]; }
+}
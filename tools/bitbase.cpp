@@ -0,0 +1,108 @@
+//
+// headless endgame bitbase checker
+//
+//   bitbase <fen>     builds the tables and probes the position
+//   bitbase suite     probes positions with known results against them
+//
+#include "../classes/Bitbase.h"
+#include <chrono>
+#include <cstdio>
+#include <string>
+
+namespace
+{
+    struct BitbaseCase
+    {
+        const char *name;
+        const char *fen;
+        bool covered;
+        int wdl;
+        int plies;
+    };
+
+    const BitbaseCase BitbaseSuite[] = {
+        { "kqk",            "8/8/8/8/8/2k5/8/K6Q b - - 0 1",        true, -1, 16 },
+        { "krk",            "8/8/8/3k4/8/8/8/R3K3 w - - 0 1",       true,  1, 27 },
+        { "kbnk",           "8/8/8/3k4/8/8/8/KBN5 w - - 0 1",       true,  1, 59 },
+        { "kbnk-black",     "kbn5/8/8/3K4/8/8/8/8 b - - 0 1",       true,  1, 59 },
+        { "kpk-sixth",      "4k3/8/4K3/4P3/8/8/8/8 b - - 0 1",      true, -1, 24 },
+        { "kpk-draw",       "8/8/8/8/4k3/8/4P3/4K3 w - - 0 1",      true,  0, 0 },
+        { "kpk-rook-pawn",  "k7/8/K7/P7/8/8/8/8 w - - 0 1",         true,  0, 0 },
+        // castling rights aren't in the tables, so such positions aren't covered
+        { "castling",       "4k3/8/8/8/8/8/8/4K2R w K - 0 1",       false, 0, 0 },
+        { "kbbk",           "4k3/8/8/8/8/8/8/2B1KB2 w - - 0 1",     false, 0, 0 },
+        { "five-pieces",    "4k3/8/8/8/8/8/8/1NB1KB2 w - - 0 1",    false, 0, 0 },
+    };
+
+    double buildTables()
+    {
+        auto start = std::chrono::steady_clock::now();
+        Bitbase::init();
+        return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    }
+
+    bool probeFEN(const char *fen, bool &covered, Bitbase::ProbeResult &result)
+    {
+        ChessPosition position;
+        if (!position.setFromFEN(fen)) {
+            std::fprintf(stderr, "invalid FEN: %s\n", fen);
+            return false;
+        }
+        result = { 0, 0 };
+        covered = Bitbase::probe(position, result);
+        return true;
+    }
+
+    int runSuite()
+    {
+        std::printf("tables built in %.2fs\n", buildTables());
+        int failures = 0;
+        for (const BitbaseCase &test : BitbaseSuite) {
+            bool covered = false;
+            Bitbase::ProbeResult result;
+            if (!probeFEN(test.fen, covered, result)) {
+                failures++;
+                continue;
+            }
+            bool passed = covered == test.covered &&
+                          (!covered || (result.wdl == test.wdl && result.plies == test.plies));
+            failures += passed ? 0 : 1;
+            std::printf("%-4s %-14s covered %d  wdl %2d  plies %2d  expected %d %2d %2d\n",
+                        passed ? "ok" : "FAIL", test.name, covered, result.wdl, result.plies,
+                        test.covered, test.wdl, test.plies);
+        }
+        std::printf("%d failure(s)\n", failures);
+        return failures ? 1 : 0;
+    }
+}
+
+int main(int argc, char **argv)
+{
+    if (argc < 2) {
+        std::fprintf(stderr, "usage: bitbase <fen>\n"
+                             "       bitbase suite\n");
+        return 1;
+    }
+
+    std::string command = argv[1];
+    if (command == "suite") {
+        return runSuite();
+    }
+
+    std::string fen = argv[1];
+    for (int i = 2; i < argc; i++) {
+        fen += std::string(" ") + argv[i];
+    }
+    std::printf("tables built in %.2fs\n", buildTables());
+    bool covered = false;
+    Bitbase::ProbeResult result;
+    if (!probeFEN(fen.c_str(), covered, result)) {
+        return 1;
+    }
+    if (!covered) {
+        std::printf("not covered\n");
+    } else {
+        std::printf("%s, %d plies to mate\n", result.wdl > 0 ? "win" : result.wdl < 0 ? "loss" : "draw", result.plies);
+    }
+    return 0;
+}
@@ -0,0 +1,120 @@
+//
+// headless perft runner
+//
+//   perft <depth> [fen]          node count, time and nodes/sec
+//   perft divide <depth> [fen]   node count below each root move
+//   perft suite [maxDepth]       standard positions against their known counts
+//
+#include "../classes/Perft.h"
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+
+namespace
+{
+    const char *StartFEN = "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1";
+
+    // everything from argument 'first' on is the FEN, since it contains spaces
+    std::string fenFromArgs(int argc, char **argv, int first)
+    {
+        if (argc <= first) {
+            return StartFEN;
+        }
+        std::string fen = argv[first];
+        for (int i = first + 1; i < argc; i++) {
+            fen += std::string(" ") + argv[i];
+        }
+        return fen;
+    }
+
+    bool loadPosition(ChessPosition &position, const std::string &fen)
+    {
+        if (!position.setFromFEN(fen)) {
+            std::fprintf(stderr, "invalid FEN: %s\n", fen.c_str());
+            return false;
+        }
+        return true;
+    }
+
+    void printResult(const PerftResult &result)
+    {
+        std::printf("nodes %llu  time %.3fs  nps %llu\n",
+                    static_cast<unsigned long long>(result.nodes), result.seconds,
+                    static_cast<unsigned long long>(result.nodesPerSecond()));
+    }
+
+    int runDivide(int depth, const std::string &fen)
+    {
+        ChessPosition position;
+        if (!loadPosition(position, fen)) {
+            return 1;
+        }
+        PerftResult total;
+        auto start = std::chrono::steady_clock::now();
+        for (const auto &entry : perftDivide(position, depth)) {
+            std::printf("%s: %llu\n", moveToString(entry.first).c_str(), static_cast<unsigned long long>(entry.second));
+            total.nodes += entry.second;
+        }
+        total.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        printResult(total);
+        return 0;
+    }
+
+    int runSuite(int maxDepth)
+    {
+        int failures = 0;
+        PerftResult total;
+        for (int i = 0; i < PerftSuiteSize; i++) {
+            const PerftCase &test = PerftSuite[i];
+            if (test.depth > maxDepth) {
+                continue;
+            }
+            ChessPosition position;
+            position.setFromFEN(test.fen);
+            PerftResult result = timedPerft(position, test.depth);
+            bool passed = result.nodes == test.nodes;
+            failures += passed ? 0 : 1;
+            total.nodes += result.nodes;
+            total.seconds += result.seconds;
+
+            std::printf("%-4s %-11s depth %d  nodes %11llu  expected %11llu  %.3fs  %llu nps\n",
+                        passed ? "ok" : "FAIL", test.name, test.depth,
+                        static_cast<unsigned long long>(result.nodes), static_cast<unsigned long long>(test.nodes),
+                        result.seconds, static_cast<unsigned long long>(result.nodesPerSecond()));
+        }
+        std::printf("total: ");
+        printResult(total);
+        std::printf("%d failure(s)\n", failures);
+        return failures ? 1 : 0;
+    }
+}
+
+int main(int argc, char **argv)
+{
+    if (argc < 2) {
+        std::fprintf(stderr, "usage: perft <depth> [fen]\n"
+                             "       perft divide <depth> [fen]\n"
+                             "       perft suite [maxDepth]\n");
+        return 1;
+    }
+
+    std::string command = argv[1];
+    if (command == "suite") {
+        return runSuite(argc > 2 ? std::atoi(argv[2]) : 99);
+    }
+    if (command == "divide") {
+        if (argc < 3) {
+            std::fprintf(stderr, "usage: perft divide <depth> [fen]\n");
+            return 1;
+        }
+        return runDivide(std::atoi(argv[2]), fenFromArgs(argc, argv, 3));
+    }
+
+    ChessPosition position;
+    if (!loadPosition(position, fenFromArgs(argc, argv, 2))) {
+        return 1;
+    }
+    printResult(timedPerft(position, std::atoi(argv[1])));
+    return 0;
+}
@@ -0,0 +1,94 @@
+//
+// Lazy SMP speedup curve
+//
+//   smpbench [maxThreads] [depth] [hashMB]
+//
+// searches a fixed set of positions to a fixed depth with 1, 2, 4 ... maxThreads
+// threads, a cleared hash table each time, and reports time-to-depth and nodes/sec
+// with the speedup of each over the single thread run, and the eval cache hit rate
+//
+#include "../classes/ChessSearch.h"
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <thread>
+#include <vector>
+
+namespace
+{
+    const char *BenchPositions[] = {
+        "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1",
+        "r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - 0 1",
+        "8/2p5/3p4/KP5r/1R3p1k/8/4P1P1/8 w - - 0 1",
+        "r3k2r/Pppp1ppp/1b3nbN/nP6/BBP1P3/q4N2/Pp1P2PP/R2Q1RK1 w kq - 0 1",
+        "rnbq1k1r/pp1Pbppp/2p5/8/2B5/8/PPP1NnPP/RNBQK2R w KQ - 1 8",
+        "r4rk1/1pp1qppp/p1np1n2/2b1p1B1/2B1P1b1/P1NP1N2/1PP1QPPP/R4RK1 w - - 0 10",
+        "r1bq1rk1/pp2ppbp/2np1np1/8/3NP3/2N1BP2/PPPQ2PP/R3KB1R w KQ - 3 9",
+        "6k1/5pp1/p3p2p/3bP3/1p1P4/1P3N1P/P4PP1/6K1 w - - 0 30",
+    };
+    const int BenchPositionCount = sizeof(BenchPositions) / sizeof(BenchPositions[0]);
+
+    struct BenchResult
+    {
+        double seconds = 0.0;
+        uint64_t nodes = 0;
+        double evalHitRate = 0.0;
+    };
+
+    BenchResult runBench(int threads, int depth, size_t hashMB)
+    {
+        ChessSearch search;
+        search.setThreads(threads);
+        search.setHashSize(hashMB);
+
+        SearchLimits limits;
+        limits.maxDepth = depth;
+
+        BenchResult total;
+        uint64_t probes = 0;
+        uint64_t hits = 0;
+        for (int i = 0; i < BenchPositionCount; i++) {
+            ChessPosition position;
+            position.setFromFEN(BenchPositions[i]);
+            search.clearHash();
+            search.findBestMove(position, limits);
+            total.seconds += search.lastResult().seconds;
+            total.nodes += search.lastResult().nodes;
+            probes += search.evalCacheStats().probes;
+            hits += search.evalCacheStats().hits;
+        }
+        total.evalHitRate = probes ? 100.0 * hits / probes : 0.0;
+        return total;
+    }
+}
+
+int main(int argc, char **argv)
+{
+    int maxThreads = argc > 1 ? std::atoi(argv[1]) : static_cast<int>(std::thread::hardware_concurrency());
+    int depth = argc > 2 ? std::atoi(argv[2]) : 10;
+    size_t hashMB = argc > 3 ? static_cast<size_t>(std::atoi(argv[3])) : 64;
+    maxThreads = std::max(maxThreads, 1);
+
+    std::vector<int> counts;
+    for (int threads = 1; threads < maxThreads; threads *= 2) {
+        counts.push_back(threads);
+    }
+    counts.push_back(maxThreads);
+
+    std::printf("%d positions, depth %d, %zu MB hash\n", BenchPositionCount, depth, hashMB);
+    std::printf("threads  time-to-depth  speedup        nodes        nps  nps-speedup  eval-cache-hits\n");
+    BenchResult baseline;
+    for (int threads : counts) {
+        BenchResult result = runBench(threads, depth, hashMB);
+        if (threads == 1) {
+            baseline = result;
+        }
+        double nps = result.seconds > 0.0 ? result.nodes / result.seconds : 0.0;
+        double baseNps = baseline.seconds > 0.0 ? baseline.nodes / baseline.seconds : 0.0;
+        std::printf("%7d  %12.3fs  %6.2fx  %11llu  %9.0f  %10.2fx  %14.1f%%\n", threads, result.seconds,
+                    result.seconds > 0.0 ? baseline.seconds / result.seconds : 0.0,
+                    static_cast<unsigned long long>(result.nodes), nps, baseNps > 0.0 ? nps / baseNps : 0.0,
+                    result.evalHitRate);
+    }
+    return 0;
+}
@@ -0,0 +1,558 @@
+//
+// Texel tuning of the evaluation weights
+//
+//   tune <positions> [epochs] [threads] [output]
+//
+// positions is a text file with one position per line: a FEN followed by the game
+// result, as 1-0 / 0-1 / 1/2-1/2 (quoted or not, EPD c9 style works too) or as a
+// white score of 1.0 / 0.5 / 0.0, optionally in brackets. Each position is quieted
+// with a captures-only search first, since the static evaluation can't see an
+// exchange in progress. The weights are then fitted to the results by minimizing
+//
+//   E = mean (result - 1 / (1 + 10^(-K * eval / 400)))^2
+//
+// with full-batch gradient descent (Adam), K having been fitted to the starting
+// weights. The tuned weights are written as a header in the format of
+// classes/EvalWeights.h (default EvalWeights.tuned.h), ready to replace it.
+//
+#include "../classes/ChessPosition.h"
+#include "../classes/Evaluation.h"
+#include "../classes/MovePicker.h"
+#include "../classes/Threading.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace
+{
+    // the trace's coefficients, not counting its trailing phase
+    constexpr int TermCount = 7 + 7 * 64 + 1 + 1 + 1 + 8 + 1 + 2;
+    static_assert(sizeof(Eval::Trace) == sizeof(int) * (TermCount + 1), "Trace must be all coefficients, then the phase");
+
+    // a tunable weight, in trace order: where its midgame and endgame values live in
+    // Eval::Weights. Either may be null, and both point at the same int for a weight
+    // shared by the two phases.
+    struct Term
+    {
+        int *mg;
+        int *eg;
+    };
+
+    struct Coefficient
+    {
+        uint16_t term;
+        int16_t value;
+    };
+
+    struct Sample
+    {
+        float result;       // 1 white won, 0.5 draw, 0 black won
+        uint8_t phase;
+        uint16_t count;
+        uint32_t first;     // index of its first coefficient
+    };
+
+    struct Dataset
+    {
+        std::vector<Sample> samples;
+        std::vector<Coefficient> coefficients;
+    };
+
+    std::vector<Term> buildTerms()
+    {
+        Eval::Params &w = Eval::Weights;
+        std::vector<Term> terms;
+        auto add = [&terms](int *mg, int *eg, int count) {
+            for (int i = 0; i < count; i++) {
+                terms.push_back({ mg ? mg + i : nullptr, eg ? eg + i : nullptr });
+            }
+        };
+        add(w.materialMg, w.materialEg, 7);
+        add(&w.pstMg[0][0], &w.pstEg[0][0], 7 * 64);
+        add(&w.kingZoneAttack, &w.kingZoneAttack, 1);
+        add(&w.doubledMg, &w.doubledEg, 1);
+        add(&w.isolatedMg, &w.isolatedEg, 1);
+        add(w.passedMg, w.passedEg, 8);
+        add(nullptr, &w.passedKingDistance, 1);
+        add(w.shieldPawn, nullptr, 2);
+        return terms;
+    }
+
+    double seconds(std::chrono::steady_clock::time_point since)
+    {
+        return std::chrono::duration<double>(std::chrono::steady_clock::now() - since).count();
+    }
+
+    // ---- loading ----
+
+    bool parseResult(const char *begin, const char *end, float &result)
+    {
+        std::string line(begin, end);
+        if (line.find("1/2-1/2") != std::string::npos) {
+            result = 0.5f;
+            return true;
+        }
+        if (line.find("1-0") != std::string::npos) {
+            result = 1.0f;
+            return true;
+        }
+        if (line.find("0-1") != std::string::npos) {
+            result = 0.0f;
+            return true;
+        }
+        // a white score as the last token, possibly in brackets
+        size_t last = line.find_last_not_of(" \t\r];\"");
+        if (last == std::string::npos) {
+            return false;
+        }
+        size_t first = line.find_last_of(" \t[\"", last);
+        first = first == std::string::npos ? 0 : first + 1;
+        char *parsedEnd = nullptr;
+        std::string token = line.substr(first, last - first + 1);
+        double value = std::strtod(token.c_str(), &parsedEnd);
+        if (parsedEnd == token.c_str() || value < 0.0 || value > 1.0) {
+            return false;
+        }
+        result = static_cast<float>(value);
+        return true;
+    }
+
+    // board, side, castling and en passant, plus the move counters if they are there
+    std::string parseFEN(const char *begin, const char *end)
+    {
+        std::string fen;
+        int fields = 0;
+        const char *p = begin;
+        while (p < end && fields < 6) {
+            while (p < end && (*p == ' ' || *p == '\t')) p++;
+            const char *tokenEnd = p;
+            while (tokenEnd < end && *tokenEnd != ' ' && *tokenEnd != '\t' && *tokenEnd != ';') tokenEnd++;
+            if (tokenEnd == p) {
+                break;
+            }
+            std::string token(p, tokenEnd);
+            if (fields >= 4 && token.find_first_not_of("0123456789") != std::string::npos) {
+                break;
+            }
+            fen += (fields ? " " : "") + token;
+            fields++;
+            p = tokenEnd;
+            if (p < end && *p == ';') break;
+        }
+        return fields >= 4 ? fen : std::string();
+    }
+
+    constexpr int MaxQuietPly = 32;
+
+    // captures-only alpha-beta, keeping the principal variation so its leaf can be traced
+    int quiesce(ChessPosition &position, int ply, int alpha, int beta,
+                ChessMove pv[MaxQuietPly][MaxQuietPly], int pvLength[MaxQuietPly])
+    {
+        pvLength[ply] = 0;
+        int standPat = Eval::evaluate(position);
+        if (position.sideToMove() == Black) {
+            standPat = -standPat;
+        }
+        if (standPat >= beta || ply == MaxQuietPly - 1) {
+            return standPat;
+        }
+        alpha = std::max(alpha, standPat);
+
+        MovePicker picker(position);
+        for (ChessMove move = picker.next(); !move.isNull(); move = picker.next()) {
+            position.makeMove(move);
+            int score = -quiesce(position, ply + 1, -beta, -alpha, pv, pvLength);
+            position.unmakeMove();
+            if (score > alpha) {
+                alpha = score;
+                pv[ply][0] = move;
+                std::copy(pv[ply + 1], pv[ply + 1] + pvLength[ply + 1], pv[ply] + 1);
+                pvLength[ply] = pvLength[ply + 1] + 1;
+                if (score >= beta) {
+                    break;
+                }
+            }
+        }
+        return alpha;
+    }
+
+    struct LoadStats
+    {
+        std::atomic<uint64_t> lines{0};
+        std::atomic<uint64_t> skipped{0};
+        std::atomic<int> modelError{0};     // largest |trace model - Eval::evaluate| seen
+    };
+
+    void loadSlice(const char *begin, const char *end, const std::vector<Term> &terms, Dataset &out, LoadStats &stats)
+    {
+        ChessPosition position;
+        ChessMove pv[MaxQuietPly][MaxQuietPly];
+        int pvLength[MaxQuietPly];
+        Eval::Trace trace;
+        uint64_t lines = 0;
+        uint64_t skipped = 0;
+        int modelError = 0;
+
+        for (const char *line = begin; line < end;) {
+            const char *lineEnd = static_cast<const char *>(std::memchr(line, '\n', end - line));
+            lineEnd = lineEnd ? lineEnd : end;
+            const char *next = lineEnd + (lineEnd < end ? 1 : 0);
+            if (lineEnd == line || *line == '#' || *line == '\r') {
+                line = next;
+                continue;
+            }
+            lines++;
+
+            float result;
+            std::string fen = parseFEN(line, lineEnd);
+            // positions in check aren't quiet, and a captures-only search can't fix that
+            if (fen.empty() || !parseResult(line, lineEnd, result) || !position.setFromFEN(fen) ||
+                position.kingSquare(White) < 0 || position.kingSquare(Black) < 0 || position.inCheck()) {
+                skipped++;
+                line = next;
+                continue;
+            }
+
+            quiesce(position, 0, -100000, 100000, pv, pvLength);
+            for (int i = 0; i < pvLength[0]; i++) {
+                position.makeMove(pv[0][i]);
+            }
+
+            Eval::trace(position, trace);
+            const int *coefficients = &trace.material[0];
+            Sample sample;
+            sample.result = result;
+            sample.phase = static_cast<uint8_t>(trace.phase);
+            sample.first = static_cast<uint32_t>(out.coefficients.size());
+            sample.count = 0;
+            int mg = 0;
+            int eg = 0;
+            for (int t = 0; t < TermCount; t++) {
+                if (coefficients[t] != 0) {
+                    out.coefficients.push_back({ static_cast<uint16_t>(t), static_cast<int16_t>(coefficients[t]) });
+                    sample.count++;
+                    mg += terms[t].mg ? coefficients[t] * *terms[t].mg : 0;
+                    eg += terms[t].eg ? coefficients[t] * *terms[t].eg : 0;
+                }
+            }
+            out.samples.push_back(sample);
+
+            int model = (mg * trace.phase + eg * (Eval::MaxPhase - trace.phase)) / Eval::MaxPhase;
+            modelError = std::max(modelError, std::abs(model - Eval::evaluate(position)));
+            line = next;
+        }
+
+        stats.lines += lines;
+        stats.skipped += skipped;
+        int seen = stats.modelError.load();
+        while (modelError > seen && !stats.modelError.compare_exchange_weak(seen, modelError)) {
+        }
+    }
+
+    bool loadDataset(const std::string &path, int threads, const std::vector<Term> &terms, Dataset &dataset)
+    {
+        auto start = std::chrono::steady_clock::now();
+        std::ifstream file(path, std::ios::binary | std::ios::ate);
+        if (!file) {
+            std::fprintf(stderr, "can't open %s\n", path.c_str());
+            return false;
+        }
+        std::vector<char> text(static_cast<size_t>(file.tellg()));
+        file.seekg(0);
+        file.read(text.data(), static_cast<std::streamsize>(text.size()));
+
+        // cut the text into one slice per thread, on line boundaries
+        std::vector<const char *> cuts = { text.data() };
+        for (int t = 1; t < threads; t++) {
+            const char *cut = text.data() + text.size() * t / threads;
+            cut = std::max(cut, cuts.back());
+            const char *newline = static_cast<const char *>(std::memchr(cut, '\n', text.data() + text.size() - cut));
+            cuts.push_back(newline ? newline + 1 : text.data() + text.size());
+        }
+        cuts.push_back(text.data() + text.size());
+
+        std::vector<Dataset> parts(threads);
+        LoadStats stats;
+        parallelFor(threads, threads, [&](int t, size_t, size_t) {
+            loadSlice(cuts[t], cuts[t + 1], terms, parts[t], stats);
+        });
+
+        for (auto &part : parts) {
+            uint32_t offset = static_cast<uint32_t>(dataset.coefficients.size());
+            for (Sample sample : part.samples) {
+                sample.first += offset;
+                dataset.samples.push_back(sample);
+            }
+            dataset.coefficients.insert(dataset.coefficients.end(), part.coefficients.begin(), part.coefficients.end());
+            part = Dataset();
+        }
+
+        std::printf("loaded %zu positions (%llu skipped) with %zu coefficients in %.1fs\n",
+                    dataset.samples.size(), static_cast<unsigned long long>(stats.skipped.load()),
+                    dataset.coefficients.size(), seconds(start));
+        // the model is exact up to the evaluation's integer rounding; more means the trace is out of date
+        std::printf("trace model vs evaluate: max difference %d\n", stats.modelError.load());
+        return !dataset.samples.empty();
+    }
+
+    // ---- fitting ----
+
+    double sigmoid(double K, double score)
+    {
+        return 1.0 / (1.0 + std::pow(10.0, -K * score / 400.0));
+    }
+
+    double sampleScore(const Dataset &dataset, const Sample &sample, const std::vector<double> &mg, const std::vector<double> &eg)
+    {
+        double mgScore = 0.0;
+        double egScore = 0.0;
+        const Coefficient *c = &dataset.coefficients[sample.first];
+        for (int i = 0; i < sample.count; i++) {
+            mgScore += c[i].value * mg[c[i].term];
+            egScore += c[i].value * eg[c[i].term];
+        }
+        return (mgScore * sample.phase + egScore * (Eval::MaxPhase - sample.phase)) / Eval::MaxPhase;
+    }
+
+    double meanError(const Dataset &dataset, int threads, double K, const std::vector<double> &mg, const std::vector<double> &eg)
+    {
+        std::vector<double> sums(threads, 0.0);
+        parallelFor(threads, dataset.samples.size(), [&](int t, size_t begin, size_t end) {
+            double sum = 0.0;
+            for (size_t i = begin; i < end; i++) {
+                const Sample &sample = dataset.samples[i];
+                double error = sample.result - sigmoid(K, sampleScore(dataset, sample, mg, eg));
+                sum += error * error;
+            }
+            sums[t] = sum;
+        });
+        double total = 0.0;
+        for (double sum : sums) total += sum;
+        return total / dataset.samples.size();
+    }
+
+    // the K that makes the starting weights fit best, so the weights stay in centipawns
+    double fitK(const Dataset &dataset, int threads, const std::vector<double> &mg, const std::vector<double> &eg)
+    {
+        double low = 0.0;
+        double high = 5.0;
+        for (int i = 0; i < 40; i++) {
+            double a = low + (high - low) / 3.0;
+            double b = high - (high - low) / 3.0;
+            if (meanError(dataset, threads, a, mg, eg) < meanError(dataset, threads, b, mg, eg)) {
+                high = b;
+            } else {
+                low = a;
+            }
+        }
+        return (low + high) / 2.0;
+    }
+
+    void gradient(const Dataset &dataset, int threads, double K, const std::vector<double> &mg, const std::vector<double> &eg,
+                  std::vector<double> &gradMg, std::vector<double> &gradEg)
+    {
+        std::vector<std::vector<double>> partMg(threads, std::vector<double>(TermCount, 0.0));
+        std::vector<std::vector<double>> partEg(threads, std::vector<double>(TermCount, 0.0));
+        parallelFor(threads, dataset.samples.size(), [&](int t, size_t begin, size_t end) {
+            std::vector<double> &localMg = partMg[t];
+            std::vector<double> &localEg = partEg[t];
+            for (size_t i = begin; i < end; i++) {
+                const Sample &sample = dataset.samples[i];
+                double s = sigmoid(K, sampleScore(dataset, sample, mg, eg));
+                // dE/dscore, up to a factor of 2 / N; the sigmoid's slope scales with K
+                double d = (s - sample.result) * s * (1.0 - s) * K * std::log(10.0) / 400.0;
+                double dMg = d * sample.phase / Eval::MaxPhase;
+                double dEg = d * (Eval::MaxPhase - sample.phase) / Eval::MaxPhase;
+                const Coefficient *c = &dataset.coefficients[sample.first];
+                for (int j = 0; j < sample.count; j++) {
+                    localMg[c[j].term] += dMg * c[j].value;
+                    localEg[c[j].term] += dEg * c[j].value;
+                }
+            }
+        });
+        std::fill(gradMg.begin(), gradMg.end(), 0.0);
+        std::fill(gradEg.begin(), gradEg.end(), 0.0);
+        for (int t = 0; t < threads; t++) {
+            for (int i = 0; i < TermCount; i++) {
+                gradMg[i] += partMg[t][i];
+                gradEg[i] += partEg[t][i];
+            }
+        }
+    }
+
+    // below this the fitted sigmoid is close to flat: the results barely depend on the
+    // evaluation, so there is nothing to fit and Adam would only drift the weights
+    constexpr double MinK = 0.05;
+
+    bool tune(const Dataset &dataset, int threads, int epochs, const std::vector<Term> &terms)
+    {
+        std::vector<double> mg(TermCount, 0.0);
+        std::vector<double> eg(TermCount, 0.0);
+        for (int i = 0; i < TermCount; i++) {
+            mg[i] = terms[i].mg ? *terms[i].mg : 0.0;
+            eg[i] = terms[i].eg ? *terms[i].eg : 0.0;
+        }
+
+        auto start = std::chrono::steady_clock::now();
+        double K = fitK(dataset, threads, mg, eg);
+        std::printf("K = %.4f  starting error %.6f\n", K, meanError(dataset, threads, K, mg, eg));
+        if (K < MinK) {
+            std::fprintf(stderr, "the results don't follow the evaluation (K = %.4f), nothing to tune\n", K);
+            return false;
+        }
+
+        // Adam, with a step of about a centipawn
+        const double rate = 1.0;
+        const double beta1 = 0.9;
+        const double beta2 = 0.999;
+        std::vector<double> gradMg(TermCount), gradEg(TermCount);
+        std::vector<double> m1(2 * TermCount, 0.0), m2(2 * TermCount, 0.0);
+
+        for (int epoch = 1; epoch <= epochs; epoch++) {
+            gradient(dataset, threads, K, mg, eg, gradMg, gradEg);
+            for (int i = 0; i < TermCount; i++) {
+                double g[2] = { terms[i].mg ? gradMg[i] : 0.0, terms[i].eg ? gradEg[i] : 0.0 };
+                // one weight for both phases gets both gradients, so its two copies stay equal
+                if (terms[i].mg && terms[i].mg == terms[i].eg) {
+                    g[0] = g[1] = gradMg[i] + gradEg[i];
+                }
+                double *value[2] = { &mg[i], &eg[i] };
+                for (int phase = 0; phase < 2; phase++) {
+                    int k = 2 * i + phase;
+                    m1[k] = beta1 * m1[k] + (1.0 - beta1) * g[phase];
+                    m2[k] = beta2 * m2[k] + (1.0 - beta2) * g[phase] * g[phase];
+                    double corrected1 = m1[k] / (1.0 - std::pow(beta1, epoch));
+                    double corrected2 = m2[k] / (1.0 - std::pow(beta2, epoch));
+                    *value[phase] -= rate * corrected1 / (std::sqrt(corrected2) + 1e-8);
+                }
+            }
+            if (epoch % 10 == 0 || epoch == epochs) {
+                std::printf("epoch %4d  error %.6f  %.1fs\n", epoch, meanError(dataset, threads, K, mg, eg), seconds(start));
+                std::fflush(stdout);
+            }
+        }
+
+        for (int i = 0; i < TermCount; i++) {
+            if (terms[i].mg) *terms[i].mg = static_cast<int>(std::lround(mg[i]));
+            if (terms[i].eg) *terms[i].eg = static_cast<int>(std::lround(eg[i]));
+        }
+        Eval::rebuildTables();
+        return true;
+    }
+
+    // ---- output ----
+
+    void writeArray(FILE *out, const int *values, int count)
+    {
+        std::fprintf(out, "{");
+        for (int i = 0; i < count; i++) {
+            std::fprintf(out, " %d%s", values[i], i + 1 < count ? "," : " ");
+        }
+        std::fprintf(out, "}");
+    }
+
+    void writeTables(FILE *out, const char *name, const int tables[7][64])
+    {
+        const char *pieceNames[7] = { "", "Pawn", "Knight", "Bishop", "Rook", "Queen", "King" };
+        std::fprintf(out, "    inline constexpr int %s[7][64] = {\n        {},\n", name);
+        for (int piece = Pawn; piece <= King; piece++) {
+            std::fprintf(out, "        // %s\n", pieceNames[piece]);
+            for (int row = 0; row < 8; row++) {
+                std::fprintf(out, "        %s", row == 0 ? "{ " : "  ");
+                for (int file = 0; file < 8; file++) {
+                    std::fprintf(out, "%4d%s", tables[piece][row * 8 + file], row == 7 && file == 7 ? " }" : ",");
+                    if (file < 7) std::fprintf(out, " ");
+                }
+                std::fprintf(out, "%s\n", row == 7 ? "," : "");
+            }
+        }
+        std::fprintf(out, "    };\n");
+    }
+
+    bool writeWeights(const std::string &path)
+    {
+        FILE *out = std::fopen(path.c_str(), "w");
+        if (!out) {
+            std::fprintf(stderr, "can't write %s\n", path.c_str());
+            return false;
+        }
+        const Eval::Params &w = Eval::Weights;
+        std::fprintf(out,
+            "#pragma once\n\n"
+            "//\n"
+            "// default evaluation weights, in centipawns. tools/tune writes a file in this\n"
+            "// same format, so tuned weights can be dropped in here.\n"
+            "//\n"
+            "// Piece-square tables are from white's point of view and laid out the way the\n"
+            "// board is printed: the first row is rank 8, the last row rank 1.\n"
+            "//\n"
+            "namespace EvalWeights\n{\n"
+            "    // by ChessPiece; the king has no material value\n");
+        std::fprintf(out, "    inline constexpr int MaterialMg[7] = ");
+        writeArray(out, w.materialMg, 7);
+        std::fprintf(out, ";\n    inline constexpr int MaterialEg[7] = ");
+        writeArray(out, w.materialEg, 7);
+        std::fprintf(out, ";\n\n");
+        writeTables(out, "PstMg", w.pstMg);
+        std::fprintf(out, "\n");
+        writeTables(out, "PstEg", w.pstEg);
+        std::fprintf(out,
+            "\n    // penalty for each square next to a king that the opponent attacks\n"
+            "    inline constexpr int KingZoneAttack = %d;\n\n"
+            "    // pawn structure, per pawn\n"
+            "    inline constexpr int DoubledMg = %d;\n"
+            "    inline constexpr int DoubledEg = %d;\n"
+            "    inline constexpr int IsolatedMg = %d;\n"
+            "    inline constexpr int IsolatedEg = %d;\n"
+            "    // passed pawns by rank, from the pawn's own side (index 1 is its starting rank)\n",
+            w.kingZoneAttack, w.doubledMg, w.doubledEg, w.isolatedMg, w.isolatedEg);
+        std::fprintf(out, "    inline constexpr int PassedMg[8] = ");
+        writeArray(out, w.passedMg, 8);
+        std::fprintf(out, ";\n    inline constexpr int PassedEg[8] = ");
+        writeArray(out, w.passedEg, 8);
+        std::fprintf(out,
+            ";\n    // endgame, per square the enemy king is further than our own from a passed pawn's stop square\n"
+            "    inline constexpr int PassedKingDistance = %d;\n"
+            "    // own pawns in front of the king on its file and the two next to it, one and two ranks up\n"
+            "    inline constexpr int ShieldPawn[2] = ",
+            w.passedKingDistance);
+        writeArray(out, w.shieldPawn, 2);
+        std::fprintf(out, ";\n}\n");
+        return std::fclose(out) == 0;
+    }
+}
+
+int main(int argc, char **argv)
+{
+    if (argc < 2) {
+        std::fprintf(stderr, "usage: tune <positions> [epochs] [threads] [output]\n");
+        return 1;
+    }
+    int epochs = argc > 2 ? std::atoi(argv[2]) : 200;
+    int threads = argc > 3 ? std::atoi(argv[3]) : static_cast<int>(std::thread::hardware_concurrency());
+    threads = std::max(threads, 1);
+    std::string output = argc > 4 ? argv[4] : "EvalWeights.tuned.h";
+
+    // setting up a position loads the default weights and the attack tables
+    ChessPosition().setFromFEN("4k3/8/8/8/8/8/8/4K3 w - - 0 1");
+    std::vector<Term> terms = buildTerms();
+
+    Dataset dataset;
+    if (!loadDataset(argv[1], threads, terms, dataset)) {
+        std::fprintf(stderr, "no usable positions in %s\n", argv[1]);
+        return 1;
+    }
+    if (!tune(dataset, threads, epochs, terms) || !writeWeights(output)) {
+        return 1;
+    }
+    std::printf("weights written to %s\n", output.c_str());
+    return 0;
+}